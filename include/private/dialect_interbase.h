@@ -18,6 +18,9 @@ public:
     virtual const String create_sequence(const String &seq_name);
     virtual const String drop_sequence(const String &seq_name);
     virtual int pager_model();
+    virtual const String sql_upsert(const String &table_name,
+            const Strings &columns, const Strings &key_columns,
+            const std::vector<Strings> &rows_params);
     // schema introspection
     virtual bool table_exists(SqlConnection &conn, const String &table);
     virtual bool view_exists(SqlConnection &conn, const String &table);
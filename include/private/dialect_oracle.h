@@ -18,6 +18,10 @@ public:
     virtual const String drop_sequence(const String &seq_name);
     virtual const String sysdate_func();
     virtual int pager_model();
+    virtual bool has_row_value_in();
+    virtual const String sql_upsert(const String &table_name,
+            const Strings &columns, const Strings &key_columns,
+            const std::vector<Strings> &rows_params);
     // schema introspection
     virtual bool table_exists(SqlConnection &conn, const String &table);
     virtual bool view_exists(SqlConnection &conn, const String &table);
@@ -14,10 +14,16 @@ public:
     virtual const String select_curr_value(const String &seq_name);
     virtual const String select_next_value(const String &seq_name);
     virtual const String select_last_inserted_id(const String &table_name);
+    virtual int inserted_id_model();
     virtual const String sql_value(const Value &x);
     virtual const String type2sql(int t);
     virtual bool fk_internal();
     virtual bool has_for_update();
+    virtual bool has_multirow_insert();
+    virtual int max_bind_params();
+    virtual const String sql_upsert(const String &table_name,
+            const Strings &columns, const Strings &key_columns,
+            const std::vector<Strings> &rows_params);
     virtual const String create_sequence(const String &seq_name);
     virtual const String drop_sequence(const String &seq_name);
     virtual const String primary_key_flag();
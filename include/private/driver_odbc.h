@@ -13,12 +13,25 @@ class OdbcCursorBackend: public SqlCursorBackend
 {
     tiodbc::connection *conn_;
     std::auto_ptr<tiodbc::statement> stmt_;
+    RowHeaderPtr header_;
+    // result columns are bound to row_array buffers and fetched
+    // in blocks, row_pos_ is the current row within the block
+    std::auto_ptr<tiodbc::row_array> rows_;
+    bool bound_;
+    int row_pos_, row_count_;
+    void bind_columns();
+    bool next_row();
+    void read_row(Row &row);
 public:
-    OdbcCursorBackend(tiodbc::connection *conn);
+    OdbcCursorBackend(tiodbc::connection *conn,
+            int block_rows = 64, int lob_size = 8000);
     void exec_direct(const String &sql);
     void prepare(const String &sql);
     void exec(const Values &params);
+    void exec_many(const std::vector<Values> &params_list);
     RowPtr fetch_row();
+    size_t fetch_block(RowBlock &block, size_t n);
+    void reset();
 };
 
 class OdbcDriver;
@@ -27,6 +40,7 @@ class OdbcConnectionBackend: public SqlConnectionBackend
 {
     std::auto_ptr<tiodbc::connection> conn_;
     OdbcDriver *drv_;
+    int block_rows_, lob_size_;
 public:
     OdbcConnectionBackend(OdbcDriver *drv);
     void open(SqlDialect *dialect, const SqlSource &source);
@@ -15,6 +15,7 @@ class QtSqlCursorBackend: public SqlCursorBackend
     QSqlDatabase *conn_;
     std::auto_ptr<QSqlQuery> stmt_;
     std::auto_ptr<QSqlRecord> rec_;
+    RowHeaderPtr header_;
     std::vector<QVariant> bound_;
     void clear();
 public:
@@ -23,6 +24,7 @@ public:
     void prepare(const String &sql);
     void exec(const Values &params);
     RowPtr fetch_row();
+    void reset();
 };
 
 class QtSqlDriver;
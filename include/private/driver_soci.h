@@ -2,6 +2,7 @@
 #ifndef YB__ORM__DRIVER_SOCI__INCLUDED
 #define YB__ORM__DRIVER_SOCI__INCLUDED
 
+#include <ctime>
 #include <memory>
 #include <vector>
 #include "util/thread.h"
@@ -10,6 +11,26 @@
 
 namespace Yb {
 
+//! Vector of values of one column or parameter for SOCI bulk operations
+struct SOCIBulkColumn
+{
+    int type_;
+    std::vector<std::string> strings_;
+    std::vector<double> doubles_;
+    std::vector<int> ints_;
+    std::vector<long long> longs_;
+    std::vector<std::tm> times_;
+    std::vector<soci::indicator> flags_;
+
+    explicit SOCIBulkColumn(int type = Value::STRING);
+    void resize(size_t n);
+    size_t size() const { return flags_.size(); }
+    void exchange_into(soci::statement &stmt);
+    void exchange_use(soci::statement &stmt);
+    void set(size_t i, const Value &v);
+    const Value get(size_t i) const;
+};
+
 class SOCICursorBackend: public SqlCursorBackend
 {
     soci::session *conn_;
@@ -20,15 +41,38 @@ class SOCICursorBackend: public SqlCursorBackend
     soci::row row_;
     std::vector<std::string> in_params_;
     std::vector<soci::indicator> in_flags_;
+    // bulk fetch: the first execution of a SELECT describes the columns
+    // without fetching, then the statement is re-bound to vectors
+    // of fetch_block_ rows and kept so for the next executions
+    int fetch_block_;
+    bool bulk_select_, bulk_done_;
+    size_t bulk_pos_;
+    RowHeaderPtr header_;
+    std::vector<SOCIBulkColumn> bulk_cols_;
+    // bulk DML: the statement bound to vectors of parameter values
+    // is prepared once and reused while the parameter types are the same
+    soci::statement *bulk_stmt_;
+    TypeCodes bulk_types_;
+    std::vector<SOCIBulkColumn> bulk_params_;
+    void exchange_params(soci::statement &stmt);
+    void describe_bulk_columns();
+    void init_bulk_select();
+    void init_bulk_dml(const TypeCodes &types);
+    bool next_bulk_row();
+    void read_bulk_row(Row &row);
+    void read_row(Row &row);
 public:
-    SOCICursorBackend(soci::session *conn);
+    SOCICursorBackend(soci::session *conn, int fetch_block = 1);
     ~SOCICursorBackend();
     void close();
     void exec_direct(const String &sql);
     void prepare(const String &sql);
     void bind_params(const TypeCodes &types);
     void exec(const Values &params);
+    void exec_many(const std::vector<Values> &params_list);
     RowPtr fetch_row();
+    size_t fetch_block(RowBlock &block, size_t n);
+    void reset();
 };
 
 class SOCIDriver;
@@ -38,6 +82,7 @@ class SOCIConnectionBackend: public SqlConnectionBackend
     soci::session *conn_;
     SOCIDriver *drv_;
     bool own_handle_;
+    int fetch_block_;
 public:
     SOCIConnectionBackend(SOCIDriver *drv);
     ~SOCIConnectionBackend();
@@ -3,6 +3,7 @@
 #define YB__ORM__DRIVER_SQLITE__INCLUDED
 
 #include <memory>
+#include <string>
 #include <vector>
 #include "util/thread.h"
 #include "orm/sql_driver.h"
@@ -18,14 +19,28 @@ class SQLiteCursorBackend: public SqlCursorBackend
     SQLiteDatabase *conn_;
     SQLiteQuery *stmt_;
     int last_code_, exec_count_;
+    RowHeaderPtr header_;
+    std::vector<int> type_hints_;
+    TypeCodes bind_types_;
+    std::vector<std::string> text_params_;
+    void bind_value(int i, const Value &x);
+    static int decl_type_hint(const char *decl_type);
+    void describe_columns();
+    const Value fetch_column(int i, int hint);
+    bool has_row();
+    void read_row(Row &row);
 public:
     SQLiteCursorBackend(SQLiteDatabase *conn);
     ~SQLiteCursorBackend();
     void close();
     void exec_direct(const String &sql);
     void prepare(const String &sql);
+    void bind_params(const TypeCodes &types);
     void exec(const Values &params);
     RowPtr fetch_row();
+    size_t fetch_block(RowBlock &block, size_t n);
+    bool last_insert_id(LongInt &id);
+    void reset();
 };
 
 class SQLiteDriver;
@@ -60,6 +60,9 @@ namespace tiodbc
 	class connection;
 	class field_impl;
 	class param_impl;
+	class param_array;
+	class bound_field;
+	class row_array;
 	class statement;	
 
 	//! @name Library Version
@@ -404,6 +407,155 @@ namespace tiodbc
 		//! @}
 	};	// !param_impl
 
+	//! Column-wise parameter arrays for statement::execute_array()
+	/**
+		Holds the values of several parameter sets, one buffer
+		per parameter, so that all the sets can be sent to the server
+		with a single SQLExecute() call. The type of a parameter is
+		fixed by the first non-NULL value assigned to it, string
+		buffers grow to fit the longest value.
+	*/
+	class param_array
+	{
+	public:
+		friend class statement;
+
+	private:
+		struct column
+		{
+			SQLSMALLINT c_type, sql_type;
+			SQLULEN col_size;
+			SQLLEN elem_sz;
+			std::vector<char> data;
+			std::vector<SQLLEN> ind;
+		};
+		int rows;
+		std::vector<column> m_cols;
+
+		column & get_column(int _par_num);
+		void * slot(int _par_num, int _row,
+				SQLSMALLINT _ctype, SQLSMALLINT _sqltype,
+				SQLLEN _elem_sz, SQLULEN _col_size = 0);
+
+		// Not copyable
+		param_array(const param_array&);
+		param_array & operator=(const param_array&);
+	public:
+		//! Construct arrays for _rows parameter sets
+		explicit param_array(int _rows);
+
+		//! Get the number of parameter sets
+		int count_rows() const { return rows; }
+
+		//! @name Value assignment functions
+		/**
+			Parameters and rows are numbered from 1 and 0 respectively.
+			A function returns <b>False</b> if the parameter has already
+			got a value of another type.
+		*/
+		//! @{
+
+		bool set_as_string(int _par_num, int _row, const _tstring & _str);
+		bool set_as_long(int _par_num, int _row, const long & _value);
+		bool set_as_long_long(int _par_num, int _row, const LongLong & _value);
+		bool set_as_double(int _par_num, int _row, const double & _value);
+		bool set_as_date_time(int _par_num, int _row,
+				const TIMESTAMP_STRUCT & _value);
+		void set_as_null(int _par_num, int _row);
+
+		//! @}
+	};	// !param_array
+
+	//! A field of a row held in row_array buffers.
+	/**
+		Has the same retrieval functions as field_impl, the value
+		is read from the bound buffer instead of calling SQLGetData.
+	@note Get one with row_array::field() and do not keep it
+		beyond the next statement::fetch_array() call.
+	*/
+	class bound_field
+	{
+	public:
+		friend class row_array;
+
+	private:
+		const char * buf;		//!< Value buffer
+		SQLLEN ind;				//!< Length or indicator
+		int type;				//!< Column data type code
+		int c_type;				//!< C data type of the buffer
+
+		bound_field(const char * _buf, SQLLEN _ind, int _type, int _c_type)
+			: buf(_buf), ind(_ind), type(_type), c_type(_c_type)
+		{}
+
+		template <class T> T get_as() const;
+
+	public:
+		_tstring as_string() const;
+		long as_long() const;
+		LongLong as_long_long() const;
+		double as_double() const;
+		const TIMESTAMP_STRUCT as_date_time() const;
+		int get_type() const { return type; }
+		int is_null() const { return ind == SQL_NULL_DATA; }
+	};	// !bound_field
+
+	//! Row-wise bound result buffers for statement::fetch_array()
+	/**
+		Each column is bound with SQLBindCol to a typed slot within
+		a row record, the slot size comes from SQLDescribeCol.
+		A block of rows is then fetched with one SQLFetch() call.
+		Columns wider than the LOB threshold, and all the columns after
+		the first of them, are left unbound and must be read with
+		statement::field(); the block size is reduced to one row then,
+		since SQLGetData can only read the current row.
+	*/
+	class row_array
+	{
+	public:
+		friend class statement;
+
+	private:
+		struct column
+		{
+			SQLSMALLINT c_type, sql_type;
+			SQLLEN offset, elem_sz;
+		};
+		int max_rows, block_rows;
+		SQLLEN max_col_sz, row_sz;
+		SQLULEN rows_fetched;
+		std::vector<column> m_cols;
+		std::vector<char> data;
+		std::vector<SQLUSMALLINT> status;
+
+		void layout(const std::vector<SQLSMALLINT> & _types,
+				const std::vector<SQLULEN> & _sizes);
+
+		// Not copyable
+		row_array(const row_array&);
+		row_array & operator=(const row_array&);
+	public:
+		//! Construct buffers for blocks of up to _rows rows
+		/**
+		@param _rows Max number of rows to fetch at once.
+		@param _max_col_sz Columns needing a bigger buffer (in bytes)
+			are not bound and read with SQLGetData instead.
+		*/
+		explicit row_array(int _rows, SQLLEN _max_col_sz = 8000);
+
+		//! Number of rows got by the last statement::fetch_array()
+		int count_rows() const { return (int)rows_fetched; }
+
+		//! Number of leading columns that are bound
+		int count_bound() const { return (int)m_cols.size(); }
+
+		//! Check if a column (numbered from 1) is bound
+		bool is_bound(int _col) const { return _col <= (int)m_cols.size(); }
+
+		//! Get a bound field, columns and rows are numbered from 1 and 0
+		const bound_field field(int _col, int _row) const;
+	};	// !row_array
+
 	//! An ODBC statement representation object
 	/**
 		Represents a statement on the server. Statement is used to
@@ -425,6 +577,8 @@ namespace tiodbc
 		HSTMT stmt_h;		//!< Handle of statement
 		bool b_open;		//!< A flag if statement has been opened
 		bool b_col_info_needed;	//!< A flag, if describe_cols() must be run
+		bool b_param_array;	//!< A flag, if parameters are bound as arrays
+		bool b_row_array;	//!< A flag, if result columns are bound
 
 		// List of parameters
 		typedef std::map<int, param_impl *> param_map_type;
@@ -440,6 +594,8 @@ namespace tiodbc
 		std::vector<col_descr> m_cols;
 
 		bool describe_cols();
+		void reset_param_array();
+		void reset_row_array();
 
 		// Uncopiable
 		statement(const statement&);
@@ -659,6 +815,17 @@ namespace tiodbc
 		*/
 		bool execute();
 
+		//! Execute a prepared query for an array of parameter sets
+		/**
+			Binds the arrays column-wise, sets SQL_ATTR_PARAMSET_SIZE
+			and executes the statement once. The parameters set
+			with param() are unbound, and the statement is reset to
+			single parameter set mode afterwards.
+		@return <b>True</b> if all the parameter sets were processed
+			successfully.
+		*/
+		bool execute_array(param_array & _params);
+
 		//! Fetch next result row
 		/**
 			If the statement has opened a result set, it
@@ -678,6 +845,24 @@ namespace tiodbc
 		*/
 		bool fetch_next();
 
+		//! Bind the result columns to row array buffers
+		/**
+			Call after execute(), the buffers are laid out according
+			to the columns of the result set. The binding holds until
+			the statement is closed or fetch_next() is called.
+		@return <b>True</b> if the columns were bound successfully.
+		*/
+		bool bind_array(row_array & _rows);
+
+		//! Fetch the next block of rows into the bound row array
+		/**
+		@return The number of rows fetched, 0 at the end of the result
+			set or on error.
+		@remarks When some columns are left unbound the block is one row,
+			read them with field() as usual.
+		*/
+		int fetch_array(row_array & _rows);
+
 		//! Get a field of the current row in the result set
 		/**
 			It will return a field of the current selected
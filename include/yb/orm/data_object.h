@@ -15,11 +15,13 @@
 #include <set>
 #include <map>
 #include "util/utility.h"
+#include "util/object_pool.h"
 #include "util/exception.h"
 #include "util/value_type.h"
 #include "orm_config.h"
 #include "schema.h"
 #include "engine.h"
+#include "identity_map.h"
 
 class TestDataObject;
 class TestDataObjectSaveLoad;
@@ -78,6 +80,12 @@ public:
     DataObjectAlreadyInSession(const Key &key);
 };
 
+class YBORM_DECL ReadOnlyObject: public ORMError
+{
+public:
+    ReadOnlyObject(const String &table_name);
+};
+
 #define EMPTY_DATAOBJ (::Yb::DataObject::Ptr(NULL))
 
 class DataObject;
@@ -91,23 +99,85 @@ typedef std::vector<DataObjectPtr> ObjectList;
 
 class Session;
 
+//! Ways to load the slave collections of a relation along with the masters
+enum EagerMode {
+    //! One more query per fetched block of rows, WHERE fk IN (...)
+    EagerSelectIn = 0,
+    //! The slave table is LEFT JOINed in the same query
+    EagerJoined = 1
+};
+
+typedef std::vector<std::pair<const Relation *, int> > EagerList;
+
 class YBORM_DECL DataObjectResultSet: public ResultSetBase<ObjectList>
 {
+    struct Eager
+    {
+        const Relation *rel;
+        int mode;
+        size_t master, master_pos, slave_pos;
+    };
+    typedef std::vector<Eager> Eagers;
+
     SqlResultSet rs_;
-    std::auto_ptr<SqlResultSet::iterator> it_;
+    RowBlock block_;
+    size_t block_pos_;
     std::vector<const Table *> tables_;
     Session &session_;
+    Eagers eager_;
+    bool joined_;
+    ObjectList pending_;
+    std::vector<RelationObject *> pending_ros_;
 
     bool fetch(ObjectList &row);
+    bool next_row();
+    void load_select_in();
+    void fill_row(Row &cur, ObjectList &row);
+    void link_joined(Row &cur);
+    void start_pending(ObjectList &row);
+    void finish_pending(ObjectList &row);
     DataObjectResultSet();
 public:
+    //! For each EagerJoined relation in eager the rows must contain
+    //! the columns of its slave table, after the columns of tables
     DataObjectResultSet(const SqlResultSet &rs, Session &session,
-                        const Strings &tables);
+                        const Strings &tables,
+                        const EagerList &eager = EagerList());
     DataObjectResultSet(const DataObjectResultSet &obj);
 };
 
 YBORM_DECL const String key2str(const Key &key);
 
+//! Intrusive list of the objects of a Session that have the same status
+class YBORM_DECL ChangeList: public NonCopyable
+{
+    DataObject *head_, *tail_;
+    size_t size_;
+public:
+    ChangeList(): head_(NULL), tail_(NULL), size_(0) {}
+    size_t size() const { return size_; }
+    bool empty() const { return !size_; }
+    DataObject *head() const { return head_; }
+    void push_back(DataObject *obj);
+    void remove(DataObject *obj);
+    //! Copy the objects out, since flushing them changes the list
+    void copy_to(std::vector<DataObject *> &out) const;
+};
+
+//! Intrusive list of the Incomplete relation objects of a relation
+class YBORM_DECL IncompleteList: public NonCopyable
+{
+    RelationObject *head_, *tail_;
+    size_t size_;
+public:
+    IncompleteList(): head_(NULL), tail_(NULL), size_(0) {}
+    size_t size() const { return size_; }
+    bool empty() const { return !size_; }
+    RelationObject *head() const { return head_; }
+    void push_back(RelationObject *ro);
+    void remove(RelationObject *ro);
+};
+
 //! Session handles persisted DataObjects
 /** Session class rules all over the mapped objects that should be
  * persisted in the database.  Session has associated Schema object
@@ -117,22 +187,47 @@ class YBORM_DECL Session: public NonCopyable
 {
     friend class ::TestDataObject;
     friend class ::TestDataObjectSaveLoad;
+    friend class DataObject;
+    friend class RelationObject;
     typedef std::set<DataObjectPtr> Objects;
-    typedef std::map<String, DataObject *> IdentityMap;
+    typedef SharedPtr<ChangeList>::Type ChangeListPtr;
+    typedef std::map<const Table *, ChangeListPtr> GhostLists;
+    typedef SharedPtr<IncompleteList>::Type IncompleteListPtr;
+    typedef std::map<const Relation *, IncompleteListPtr> IncompleteLists;
 
     ILogger::Ptr logger_, engine_logger_;
     Objects objects_;
     IdentityMap identity_map_;
+    // New, Dirty, ToBeDeleted and Deleted objects, and Ghosts
+    // by their tables, Sync objects aren't listed
+    ChangeList new_objs_, dirty_objs_, to_delete_objs_, deleted_objs_;
+    GhostLists ghost_objs_;
+    // Incomplete relation objects of the session's masters by relation
+    IncompleteLists incomplete_objs_;
     const Schema &schema_;
     std::auto_ptr<EngineSource> created_engine_;
     std::auto_ptr<EngineCloned> engine_;
+    bool refresh_loaded_, stateless_;
+    size_t ghost_batch_;
+    Values key_buf_;
+    ObjectPool::Ptr pool_;
 
     DataObject *add_to_identity_map(DataObject *obj, bool return_found);
-    void flush_tbl_new_keyed(const Table &tbl, Objects &keyed_objs);
-    void flush_tbl_new_unkeyed(const Table &tbl, Objects &unkeyed_objs);
+    ChangeList *change_list(const DataObject *obj);
+    //! Move the object to the change list of its current status
+    void update_change_list(DataObject *obj);
+    //! Put the relation object in the list of its relation
+    //! if it's Incomplete, take it out otherwise
+    void update_incomplete_list(RelationObject *ro);
+    void flush_tbl_new_keyed(const Table &tbl,
+            std::vector<DataObject *> &keyed_objs);
+    void flush_tbl_new_unkeyed(const Table &tbl,
+            std::vector<DataObject *> &unkeyed_objs);
+    void flush_tbl_new(const Table &tbl,
+            const std::vector<DataObject *> &objs);
     void flush_new();
-    void flush_update(IdentityMap &idmap_copy);
-    void flush_delete(IdentityMap &idmap_copy);
+    void flush_update();
+    void flush_delete();
     void clone_engine(EngineSource *src_engine);
 public:
     void set_logger(ILogger::Ptr logger);
@@ -152,8 +247,11 @@ public:
     }
     //! Save a detached or new DataObject into Session
     void save(DataObjectPtr obj);
-    //! 
-    DataObjectPtr save_or_update(DataObjectPtr obj);
+    //! Save a DataObject or copy its data into the one with the same key.
+    //! With upsert = true a New object is flushed with an UPSERT,
+    //! for the case when it's not known if the row exists in the database,
+    //! such an object must have its key assigned, or NullPK is thrown
+    DataObjectPtr save_or_update(DataObjectPtr obj, bool upsert = false);
     //! Tell session to release a DataObject
     void detach(DataObjectPtr obj);
     /** Get pointer to a DataObject by key provided
@@ -162,6 +260,54 @@ public:
      * placed in the identity_map_ and returned.
      */
     DataObjectPtr get_lazy(const Key &key);
+    /** Get pointers to DataObjects by keys, like get_lazy() does,
+     * then load all the Ghosts among them with WHERE pk IN (...) queries,
+     * at most batch keys per query.  The objects are returned in the
+     * order of keys, those not found in the database are left Ghosts.
+     */
+    ObjectList get_many(const Keys &keys, size_t batch = 100);
+    size_t ghost_batch() const { return ghost_batch_; }
+    //! When a Ghost is loaded, load up to n - 1 other Ghosts
+    //! of the same table with the same query (default 1, no batching)
+    void set_ghost_batch(size_t n) { ghost_batch_ = n > 1? n: 1; }
+    //! Append Ghosts of the table in the order they became Ghosts,
+    //! until batch has n items
+    void add_ghosts(const Table &table, size_t n,
+                    std::vector<DataObject *> &batch);
+    //! Fill the Ghosts of the table with a single query
+    void load_ghosts(const Table &table,
+                     const std::vector<DataObject *> &ghosts);
+    /** Get the object for the table's columns in the row at pos.
+     * The identity_map_ is probed by the key first, and a found object
+     * is refilled from the row if it's a Ghost or refresh_loaded() is on.
+     * A new DataObject is only created if the key is not found.
+     * In stateless mode a new read-only object is always created.
+     */
+    DataObjectPtr load_from_row(const Table &table, Row &row, size_t pos);
+    bool refresh_loaded() const { return refresh_loaded_; }
+    //! Whether the objects found in session while loading are
+    //! refreshed with the data from the database (default) or kept as is
+    void set_refresh_loaded(bool refresh) { refresh_loaded_ = refresh; }
+    bool stateless() const { return stateless_; }
+    /** In stateless mode the loaded objects are not tracked by
+     * the session: each row makes a new read-only DataObject,
+     * not bound to any session, so nothing is kept in the session
+     * however many rows are read.  Such objects can't be changed,
+     * saved or deleted, their relations are not loaded lazily,
+     * and eager loading is not available.
+     */
+    void set_stateless(bool stateless) { stateless_ = stateless; }
+    ObjectPool *object_pool() const { return pool_.get(); }
+    //! Take the memory for the objects loaded by the session and
+    //! for their relation objects from the pool, NULL turns it off.
+    //! On clear() the pool is replaced with a new one, so the memory
+    //! of the old one is freed at once when its last object is gone
+    void set_object_pool(ObjectPool *pool) { pool_ = ObjectPool::Ptr(pool); }
+    //! Append the not yet loaded slave collections of the relation,
+    //! in the order they were created, skipping those of New and
+    //! deleted masters, until batch has n items
+    void add_incomplete_slaves(const Relation &r, size_t n,
+                               std::vector<RelationObject *> &batch);
     void flush();
     void commit();
     void rollback();
@@ -176,7 +322,8 @@ public:
             const Expression &order_by = Expression(),
             bool for_update_flag = false);
     DataObjectResultSet load_collection(
-            const Strings &tables, const SelectExpr &select_expr);
+            const Strings &tables, const SelectExpr &select_expr,
+            const EagerList &eager = EagerList());
 };
 
 enum DeletionMode { DelNormal, DelDryRun, DelUnchecked };
@@ -196,25 +343,30 @@ enum DeletionMode { DelNormal, DelDryRun, DelUnchecked };
 </ul>
 */
 class YBORM_DECL DataObject
-    : private NonCopyable, public RefCountBase
+    : private NonCopyable, public RefCountBase, public PoolObject
 {
     friend class Session;
+    friend class ChangeList;
 public:
     typedef DataObjectPtr Ptr;
     typedef Values::iterator iterator;
     enum Status { New, Ghost, Dirty, Sync, ToBeDeleted, Deleted };
     typedef std::map<const Relation *, RelationObject * > SlaveRelations;
     typedef std::map<const Relation *, RelationObjectPtr> MasterRelations;
+    typedef std::map<const DataObject *, int> TableDepths;
 private:
     const Table &table_;
     Values values_;
+    ColumnMask changed_;
     Status status_;
     SlaveRelations slave_relations_;
     MasterRelations master_relations_;
     Session *session_;
+    ChangeList *change_list_;
+    DataObject *prev_changed_, *next_changed_;
     Key key_;
     String key_str_;
-    bool assigned_key_;
+    bool upsert_, read_only_;
     int depth_;
 
     DataObject(const Table &table, Status status)
@@ -222,7 +374,11 @@ private:
         , values_(table.size())
         , status_(status)
         , session_(NULL)
-        , assigned_key_(false)
+        , change_list_(NULL)
+        , prev_changed_(NULL)
+        , next_changed_(NULL)
+        , upsert_(false)
+        , read_only_(false)
         , depth_(0)
     {}
     void update_key();
@@ -231,16 +387,24 @@ private:
         if ((!c || !c->is_pk()) && status_ == Ghost)
             load();
     }
-    void set_status(Status st) { status_ = st; }
-    void depth(int d) { depth_ = d; }
+    void set_status(Status st) {
+        status_ = st;
+        if (st != Dirty)
+            changed_.clear();
+        if (session_)
+            session_->update_change_list(this);
+    }
+    void touch(int i);
     void populate_all_master_relations();
 public:
     static void link(DataObject *master, Ptr slave,
                      const String &relation_name, int mode);
     static void link(DataObject *master, Ptr slave,
                      const Relation &r);
-    static Ptr create_new(const Table &table, Status status = New) {
-        return Ptr(new DataObject(table, status));
+    static Ptr create_new(const Table &table, Status status = New,
+                          ObjectPool *pool = NULL)
+    {
+        return Ptr(new (pool) DataObject(table, status));
     }
     ~DataObject();
     const Table &table() const { return table_; }
@@ -257,6 +421,7 @@ public:
     iterator end() { return values_.end(); }
     size_t size() const { return values_.size(); }
     int depth() const { return depth_; }
+    void depth(int d) { depth_ = d; }
     Value &get(int i) {
         lazy_load(&table_[i]);
         return values_[i];
@@ -265,15 +430,26 @@ public:
         return get(table_.idx_by_name(name));
     }
     void touch();
+    //! Columns changed since the object was last in sync,
+    //! empty if the object is not Dirty
+    const ColumnMask &changed_columns() const { return changed_; }
     void set(int i, const Value &v);
     void set(const String &name, const Value &v) {
         set(table_.idx_by_name(name), v);
     }
     const Key &key();
     const String &key_str();
+    //! Binary key made of the object's PK values, used by IdentityMap
+    ObjectKey object_key() const { return ObjectKey(table_, &values_[0]); }
     Key fk_value_for(const Relation &r);
     const Values &raw_values() const { return values_; }
     bool assigned_key();
+    //! A New object with its key assigned is flushed with an UPSERT:
+    //! inserted, or its data written over the row with the same key
+    bool upsert() const { return upsert_; }
+    //! Objects loaded by a stateless Session are read-only
+    bool read_only() const { return read_only_; }
+    void set_upsert(bool upsert) { upsert_ = upsert; }
     SlaveRelations &slave_relations() {
         return slave_relations_;
     }
@@ -303,6 +479,9 @@ public:
     RelationObject *get_slaves(const Relation &r);
     RelationObject *get_slaves(const String &relation_name = _T(""));
     void calc_depth(int d, DataObject *parent = NULL);
+    //! Depth of a New object among the New objects of its own table,
+    //! kept in depths, throws CycleDetected if it gets over max_depth
+    void calc_table_depth(int d, int max_depth, TableDepths &depths);
     void dump_tree(std::ostream &out, int level = 0);
 };
 
@@ -316,13 +495,16 @@ public:
 </ul>
 */
 class YBORM_DECL RelationObject
-    : private NonCopyable, public RefCountBase
+    : private NonCopyable, public RefCountBase, public PoolObject
 {
     friend class DataObject;
+    friend class Session;
+    friend class IncompleteList;
 public:
     typedef RelationObjectPtr Ptr;
     typedef std::vector<DataObject::Ptr> SlaveObjects;
     typedef std::map<DataObject *, int> SlaveObjectsOrder;
+    typedef std::vector<RelationObject *> Batch;
     enum Status { Incomplete, Sync };
 private:
     const Relation &relation_info_;
@@ -330,28 +512,50 @@ private:
     SlaveObjects slave_objects_;
     SlaveObjectsOrder slave_order_;
     Status status_;
+    IncompleteList *incomplete_list_;
+    RelationObject *prev_incomplete_, *next_incomplete_;
 
     RelationObject(const Relation &rel_info, DataObject *master)
         : relation_info_(rel_info)
         , master_object_(master)
         , status_(Incomplete)
+        , incomplete_list_(NULL)
+        , prev_incomplete_(NULL)
+        , next_incomplete_(NULL)
     {}
+    void update_incomplete_list();
     void add_slave(DataObject::Ptr slave);
     void remove_slave(DataObject::Ptr slave);
 public:
-    static Ptr create_new(const Relation &rel_info, DataObject *master) {
-        return Ptr(new RelationObject(rel_info, master));
+    //! Load the slaves of all the Incomplete relation objects in batch
+    //! with a single query, and mark them Sync
+    static void load_slaves(Session &session, const Relation &r,
+                            const Batch &batch);
+    static Ptr create_new(const Relation &rel_info, DataObject *master,
+                          ObjectPool *pool = NULL)
+    {
+        Ptr ro(new (pool) RelationObject(rel_info, master));
+        ro->update_incomplete_list();
+        return ro;
     }
+    ~RelationObject();
     const Relation &relation_info() const { return relation_info_; }
     void master_object(DataObject *obj) { master_object_ = obj; }
     DataObject *master_object() const { return master_object_; }
     SlaveObjects &slave_objects() { return slave_objects_; }
     SlaveObjects::iterator find(DataObject *obj);
-    void status(Status stat) { status_ = stat; }
+    void status(Status stat) {
+        status_ = stat;
+        update_incomplete_list();
+    }
     Status status() const { return status_; }
     void calc_depth(int d, DataObject *parent = NULL);
+    void calc_table_depth(int d, int max_depth,
+            DataObject::TableDepths &depths);
     const Key gen_fkey() const;
     size_t count_slaves();
+    //! Load the slave objects, along with the slaves of up to
+    //! batch_size() - 1 other masters of the relation from the session
     void lazy_load_slaves();
     void refresh_slaves_fkeys();
 
@@ -462,7 +462,8 @@ public:
         : rs_(rs)
     {}
     DomainResultSet(const DomainResultSet &obj)
-        : rs_(obj.rs_)
+        : ResultSetBase<boost::tuple<T0, T1, T2, T3, T4, T5, T6, T7, T8, T9> >(obj.prefetch())
+        , rs_(obj.rs_)
     {
         YB_ASSERT(!obj.it_.get());
     }
@@ -534,7 +535,8 @@ public:
         : rs_(rs)
     {}
     DomainResultSet(const DomainResultSet &obj)
-        : rs_(obj.rs_)
+        : ResultSetBase<std::tuple<Tp...>>(obj.prefetch())
+        , rs_(obj.rs_)
     {
         YB_ASSERT(!obj.it_.get());
     }
@@ -585,7 +587,8 @@ public:
         : rs_(rs)
     {}
     DomainResultSet(const DomainResultSet &obj)
-        : rs_(obj.rs_)
+        : ResultSetBase<R>(obj.prefetch())
+        , rs_(obj.rs_)
     {
         YB_ASSERT(!obj.it_.get());
     }
@@ -610,6 +613,51 @@ class QueryObj {
     Expression filter_, order_;
     bool for_update_;
     int limit_, offset_;
+    EagerList eager_;
+
+    DataObjectResultSet load_all() {
+        Strings tables;
+        QF::list_tables(tables);
+        if (eager_.empty()) {
+            SelectExpr select_expr = get_select(tables);
+            return session_->load_collection(tables, select_expr);
+        }
+        // LIMIT would count the joined rows, so use select-in instead
+        EagerList eager(eager_);
+        bool joined = false;
+        EagerList::iterator i = eager.begin(), iend = eager.end();
+        for (; i != iend; ++i) {
+            if (i->second == EagerJoined && limit_)
+                i->second = EagerSelectIn;
+            if (i->second == EagerJoined)
+                joined = true;
+        }
+        const Schema &schema = session_->schema();
+        Expression from = schema.join_expr(tables), order = order_;
+        if (joined) {
+            // keep the rows of each master together
+            String order_sql = order_.is_empty()? String(): order_.get_sql();
+            const Table &master = schema.table(tables[0]);
+            Strings::const_iterator j = master.pk_fields().begin(),
+                jend = master.pk_fields().end();
+            for (; j != jend; ++j)
+                order_sql += (str_empty(order_sql)? _T(""): _T(", ")) +
+                    ColumnExpr(master.name(), *j).get_sql();
+            for (i = eager.begin(); i != iend; ++i) {
+                if (i->second != EagerJoined)
+                    continue;
+                const Relation &r = *i->first;
+                from = JoinExpr(from, Expression(r.table(1).name()),
+                        r.join_condition(), _T("LEFT JOIN"));
+                if (r.has_non_empty_attr(1, _T("order-by")))
+                    order_sql += _T(", ") + r.joined_order_by();
+            }
+            order = Expression(order_sql);
+        }
+        SelectExpr select_expr = make_select(schema, from, filter_, order,
+                for_update_, limit_, offset_);
+        return session_->load_collection(tables, select_expr, eager);
+    }
 public:
     QueryObj(Session &session, const Expression &filter = Expression(),
             const Expression &order = Expression(), bool for_update = false)
@@ -666,6 +714,29 @@ public:
         q.offset_ = start;
         return q;
     }
+    //! Load the collections of the one-to-many relation from R to D along
+    //! with R objects, so that iterating them won't query the database.
+    //! EagerSelectIn issues one more query per block of fetched rows,
+    //! EagerJoined uses LEFT JOIN (or select-in if range() is used),
+    //! bare columns of the relation's order-by get the D table prefix.
+    //! The property of R side chooses one of several relations.
+    template <class D>
+    QueryObj eager(int mode = EagerSelectIn,
+                   const String &property = _T(""))
+    {
+        const Schema &schema = session_->schema();
+        const Table &master = schema.table(R::get_table_name()),
+            &slave = schema.table(D::get_table_name());
+        const Relation *r = schema.find_relation(
+                master.class_name(), property, slave.class_name());
+        if (!r || r->type() != Relation::ONE2MANY ||
+                &r->table(0) != &master)
+            throw ORMError(_T("No one-to-many relation from ") +
+                    master.name() + _T(" to ") + slave.name());
+        QueryObj q(*this);
+        q.eager_.push_back(std::make_pair(r, (int)mode));
+        return q;
+    }
     SelectExpr get_select(Strings &tables) {
         QF::list_tables(tables);
         return make_select(session_->schema(),
@@ -673,16 +744,10 @@ public:
                 filter_, order_, for_update_, limit_, offset_);
     }
     DomainResultSet<R> all() {
-        Strings tables;
-        SelectExpr select_expr = get_select(tables);
-        return DomainResultSet<R>(session_->load_collection(
-                    tables, select_expr));
+        return DomainResultSet<R>(load_all());
     }
     R one() {
-        Strings tables;
-        SelectExpr select_expr = get_select(tables);
-        DomainResultSet<R> r = session_->load_collection(
-                tables, select_expr);
+        DomainResultSet<R> r = load_all();
         typename DomainResultSet<R>::iterator it = r.begin();
         if (it == r.end())
             throw NoDataFound("No data");
@@ -697,7 +762,7 @@ public:
         select.from_(ColumnExpr(get_select(tables), _T("X")));
         SqlResultSet rs = session_->engine()->select_iter(select);
         Row r = *rs.begin(); 
-        return r[0].second.as_longint();
+        return r[0].as_longint();
     }
     R first() { return range(0, 1).one(); }
 };
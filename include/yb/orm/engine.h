@@ -14,12 +14,16 @@
 #include "expression.h"
 #include "sql_driver.h"
 #include "sql_pool.h"
+#include "id_allocator.h"
 #include "schema.h"
 
 class TestEngine;
 
 namespace Yb {
 
+//! Per-column flags, indexed the same way as the Table columns
+typedef std::vector<bool> ColumnMask;
+
 class YBORM_DECL EngineBase
 {
 public:
@@ -30,6 +34,9 @@ public:
     virtual SqlDialect *get_dialect() = 0;
     virtual ILogger *logger() = 0;
     virtual int get_mode() = 0;
+    //! The allocator of surrogate key values, with NULL (the default)
+    //! each value is taken from the sequence with get_next_value()
+    virtual IdAllocator *id_allocator();
 
     SqlResultSet select_iter(const Expression &select_expr);
     RowsPtr select(
@@ -44,7 +51,12 @@ public:
     const std::vector<LongInt> insert(const Table &table,
             const RowsData &rows, bool collect_new_ids);
     void update(const Table &table, const RowsData &rows);
+    //! Update only the columns set in the mask, empty mask = all columns
+    void update(const Table &table, const RowsData &rows,
+            const ColumnMask &columns);
     void delete_from(const Table &table, const Keys &keys);
+    //! Insert the rows or update the existing ones having the same key
+    void upsert(const Table &table, const RowsData &rows);
     void exec_proc(const String &proc_code);
     RowPtr select_row(const Expression &what,
             const Expression &from, const Expression &where);
@@ -52,6 +64,8 @@ public:
             const Expression &from, const Expression &where);
     LongInt get_curr_value(const String &seq_name);
     LongInt get_next_value(const String &seq_name);
+    //! Next surrogate key value for a sequence, via the id allocator
+    LongInt allocate_id(const String &seq_name);
     void commit();
     void rollback();
     void touch();
@@ -61,12 +75,35 @@ public:
 
     static void gen_sql_insert(String &sql, TypeCodes &type_codes,
             ParamNums &param_nums, const Table &table,
-            bool include_pk, bool numbered_params = false);
+            bool include_pk, bool numbered_params = false,
+            int batch_rows = 1);
     static void gen_sql_update(String &sql, TypeCodes &type_codes,
             ParamNums &param_nums, const Table &table, 
-            const SqlGeneratorOptions &options);
+            const SqlGeneratorOptions &options,
+            const ColumnMask *columns = NULL);
+    static int calc_insert_batch(SqlConnection *conn, int row_params);
+    static void gen_sql_upsert(String &sql, TypeCodes &type_codes,
+            ParamNums &param_nums, const Table &table, SqlDialect *dialect,
+            bool numbered_params = false, int batch_rows = 1);
     static void gen_sql_delete(String &sql, TypeCodes &type_codes,
-            const Table &table, const SqlGeneratorOptions &options);
+            const Table &table, const SqlGeneratorOptions &options,
+            int batch_keys = 1, bool row_value_in = false);
+    static int calc_delete_batch(SqlConnection *conn, int key_params);
+    //! Precompiled statements, built once and kept in the Table
+    static const DmlPlan &insert_plan(const Table &table,
+            bool include_pk, bool numbered_params, int batch_rows = 1);
+    static const DmlPlan &update_plan(const Table &table,
+            bool numbered_params, const ColumnMask &columns);
+    static const DmlPlan &delete_plan(const Table &table,
+            bool numbered_params, int batch_keys = 1,
+            bool row_value_in = false);
+    static const DmlPlan &upsert_plan(const Table &table,
+            SqlDialect *dialect, bool numbered_params, int batch_rows = 1);
+    //! Same statements, not cached, for a short last chunk of rows
+    static void build_insert_plan(DmlPlan &plan, const Table &table,
+            bool include_pk, bool numbered_params, int batch_rows);
+    static void build_upsert_plan(DmlPlan &plan, const Table &table,
+            SqlDialect *dialect, bool numbered_params, int batch_rows);
 };
 
 class YBORM_DECL EngineCloned: public EngineBase
@@ -76,18 +113,21 @@ class YBORM_DECL EngineCloned: public EngineBase
     SqlDialect *dialect_;
     ILogger *logger_;
     SqlPool *pool_;
+    IdAllocator *id_allocator_;
 public:
     EngineCloned(int mode, SqlConnection *conn,
             SqlDialect *dialect, ILogger *logger,
-            SqlPool *pool = NULL)
+            SqlPool *pool = NULL, IdAllocator *id_allocator = NULL)
         : mode_(mode)
         , conn_(conn)
         , dialect_(dialect)
         , logger_(logger)
         , pool_(pool)
+        , id_allocator_(id_allocator)
     {}
     ~EngineCloned();
     int get_mode();
+    IdAllocator *id_allocator();
     SqlConnection *get_conn();
     SqlDialect *get_dialect();
     ILogger *logger();
@@ -119,6 +159,8 @@ public:
     ~Engine();
 
     int get_mode();
+    IdAllocator *id_allocator();
+    void set_id_allocator(std::auto_ptr<IdAllocator> id_allocator);
     SqlConnection *get_conn();
     SqlDialect *get_dialect();
     ILogger *logger();
@@ -137,6 +179,7 @@ private:
     std::auto_ptr<SqlConnection> conn_;
     SqlDialect *dialect_;
     SqlConnection *conn_ptr_;
+    std::auto_ptr<IdAllocator> id_allocator_;
 };
 
 } // namespace Yb
@@ -190,23 +190,28 @@ public:
 class YBORM_DECL JoinExprBackend: public ExpressionBackend
 {
     Expression expr1_, expr2_, cond_;
+    String kind_;
 public:
     JoinExprBackend(const Expression &expr1,
-            const Expression &expr2, const Expression &cond)
-        : expr1_(expr1), expr2_(expr2), cond_(cond) {}
+            const Expression &expr2, const Expression &cond,
+            const String &kind = _T("JOIN"))
+        : expr1_(expr1), expr2_(expr2), cond_(cond), kind_(kind) {}
     const String generate_sql(
             const SqlGeneratorOptions &options,
             SqlGeneratorContext *ctx) const;
     const Expression &expr1() const { return expr1_; }
     const Expression &expr2() const { return expr2_; }
     const Expression &cond() const { return cond_; }
+    const String &kind() const { return kind_; }
 };
 
 class YBORM_DECL JoinExpr: public Expression
 {
 public:
+    //! kind is the join keyword, e.g. "JOIN" or "LEFT JOIN"
     JoinExpr(const Expression &expr1,
-            const Expression &expr2, const Expression &cond);
+            const Expression &expr2, const Expression &cond,
+            const String &kind = _T("JOIN"));
     const Expression &expr1() const;
     const Expression &expr2() const;
     const Expression &cond() const;
@@ -448,6 +453,11 @@ public:
     const Key &key() const;
 };
 
+//! Filter matching any of the keys, which must belong to the same table:
+//! a single column key gives "T.C IN (...)", a compound one gives
+//! the key filters joined with OR
+YBORM_DECL const Expression filter_keys(const Keys &keys);
+
 typedef Expression Filter;
 
 class Schema;
@@ -0,0 +1,72 @@
+// -*- Mode: C++; c-basic-offset: 4; tab-width: 4; indent-tabs-mode: nil; -*-
+#ifndef YB__ORM__ID_ALLOCATOR__INCLUDED
+#define YB__ORM__ID_ALLOCATOR__INCLUDED
+
+#include <map>
+#include <memory>
+#include "util/thread.h"
+#include "util/value_type.h"
+#include "orm_config.h"
+
+namespace Yb {
+
+class EngineBase;
+class SqlSource;
+
+//! Source of surrogate key values for tables using a sequence
+class YBORM_DECL IdAllocator: NonCopyable
+{
+public:
+    virtual ~IdAllocator();
+    virtual LongInt next_id(EngineBase &engine, const String &seq_name) = 0;
+};
+
+//! Takes each id directly from the sequence, one round trip per id
+class YBORM_DECL SequenceIdAllocator: public IdAllocator
+{
+public:
+    LongInt next_id(EngineBase &engine, const String &seq_name);
+};
+
+//! Hands out ids from blocks, reserving a block with one sequence call.
+//! In HI_LO mode a sequence value v yields ids [v*n, v*n + n).
+//! In INCREMENT_BY mode the sequence must be created with INCREMENT BY n,
+//! and a sequence value v yields ids [v, v + n).
+//! The allocator is thread safe and can be shared by several engines,
+//! the sequence is called without holding its lock.
+class YBORM_DECL HiLoIdAllocator: public IdAllocator
+{
+public:
+    enum BlockMode { HI_LO = 0, INCREMENT_BY = 1 };
+    explicit HiLoIdAllocator(int block_size, int block_mode = HI_LO);
+    int block_size() const { return block_size_; }
+    int block_mode() const { return block_mode_; }
+    LongInt next_id(EngineBase &engine, const String &seq_name);
+protected:
+    //! Fetch the next value of the sequence, one call per block
+    virtual LongInt reserve_block(EngineBase &engine, const String &seq_name);
+private:
+    //! The current block and one reserved ahead, which is kept
+    //! when two threads have called the sequence at the same time
+    struct Block
+    {
+        LongInt next, end, spare_next, spare_end;
+        Block(): next(0), end(0), spare_next(0), spare_end(0) {}
+    };
+    typedef std::map<String, Block> Blocks;
+    static bool take_id(Block &block, LongInt &id);
+    Mutex mux_;
+    int block_size_, block_mode_;
+    Blocks blocks_;
+};
+
+//! Create an allocator according to the source options:
+//! id_block=N sets the block size (default 1, no blocks),
+//! id_block_mode=hilo|increment_by selects the block mode.
+YBORM_DECL std::auto_ptr<IdAllocator> new_id_allocator(
+        const SqlSource &source);
+
+} // namespace Yb
+
+// vim:ts=4:sts=4:sw=4:et:
+#endif // YB__ORM__ID_ALLOCATOR__INCLUDED
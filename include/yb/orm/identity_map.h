@@ -0,0 +1,117 @@
+// -*- Mode: C++; c-basic-offset: 4; tab-width: 4; indent-tabs-mode: nil; -*-
+#ifndef YB__ORM__IDENTITY_MAP__INCLUDED
+#define YB__ORM__IDENTITY_MAP__INCLUDED
+
+#include <vector>
+#include "util/value_type.h"
+#include "orm_config.h"
+#include "schema.h"
+
+namespace Yb {
+
+class DataObject;
+
+//! Binary key of a persisted object: the table and its typed PK values
+/** ObjectKey does not own the values, it points either to a row
+ * of the table's columns, with PK values at Table::pk_indexes(),
+ * or to PK values that go one after another in pk_fields() order.
+ * The values are expected to be converted to the columns' types.
+ * The hash is computed once on construction, so making a key
+ * and probing the IdentityMap with it never allocates.
+ */
+class YBORM_DECL ObjectKey
+{
+    const Table *table_;
+    const Value *values_;
+    bool packed_;
+    size_t hash_;
+    ObjectKey(const Table &table, const Value *values, bool packed);
+    void init_hash();
+public:
+    //! Key of the table's row, the row must live longer than the key
+    ObjectKey(const Table &table, const Value *row);
+    //! Key made of pk_fields().size() consecutive values
+    static ObjectKey packed(const Table &table, const Value *pk_values) {
+        return ObjectKey(table, pk_values, true);
+    }
+    const Table &table() const { return *table_; }
+    size_t size() const { return table_->pk_indexes().size(); }
+    const Value &value(size_t i) const {
+        return values_[packed_? i: table_->pk_indexes()[i]];
+    }
+    size_t hash() const { return hash_; }
+    //! Whether none of the PK values is NULL
+    bool assigned() const;
+    bool operator==(const ObjectKey &other) const;
+    bool operator!=(const ObjectKey &other) const {
+        return !(*this == other);
+    }
+};
+
+//! Hash of a single value, equal values give equal hashes
+YBORM_DECL size_t hash_value(const Value &x);
+
+//! Objects by their keys, an open addressing hash table
+/** The table is probed linearly, its capacity is a power of two
+ * and it is kept no more than half full.  The objects are
+ * not owned, the key of each object is taken from its own values,
+ * so the PK values of an object must not change while it is in the map.
+ */
+class YBORM_DECL IdentityMap
+{
+    struct Slot
+    {
+        DataObject *obj;
+        size_t hash;
+    };
+    typedef std::vector<Slot> Slots;
+    Slots slots_;
+    size_t size_;
+
+    size_t find_slot(const ObjectKey &key) const;
+    void grow();
+public:
+    class const_iterator
+    {
+        const Slots *slots_;
+        size_t pos_;
+        void skip() {
+            while (pos_ < slots_->size() && !(*slots_)[pos_].obj)
+                ++pos_;
+        }
+    public:
+        const_iterator(const Slots &slots, size_t pos)
+            : slots_(&slots), pos_(pos)
+        { skip(); }
+        DataObject *operator*() const { return (*slots_)[pos_].obj; }
+        const_iterator &operator++() { ++pos_; skip(); return *this; }
+        bool operator==(const const_iterator &other) const {
+            return pos_ == other.pos_;
+        }
+        bool operator!=(const const_iterator &other) const {
+            return pos_ != other.pos_;
+        }
+    };
+
+    IdentityMap(): size_(0) {}
+    size_t size() const { return size_; }
+    bool empty() const { return !size_; }
+    const_iterator begin() const { return const_iterator(slots_, 0); }
+    const_iterator end() const {
+        return const_iterator(slots_, slots_.size());
+    }
+    //! The object with the key, NULL if there is none
+    DataObject *find(const ObjectKey &key) const;
+    //! Add the object with its key and return NULL, unless there is
+    //! already an object with such key, which is then returned
+    DataObject *insert(const ObjectKey &key, DataObject *obj);
+    //! Remove the object with the key, the slots after it are shifted back
+    bool erase(const ObjectKey &key);
+    void clear();
+    void swap(IdentityMap &other);
+};
+
+} // namespace Yb
+
+// vim:ts=4:sts=4:sw=4:et:
+#endif // YB__ORM__IDENTITY_MAP__INCLUDED
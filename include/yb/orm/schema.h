@@ -182,6 +182,18 @@ typedef std::map<String, int> IndexMap;
 class Schema;
 class Relation;
 
+//! Precompiled DML statement for a table
+/** Holds the SQL text with placeholders, the types of parameters
+ * and, for each parameter slot, the index of the column to take
+ * the value from.  A plan is never changed once built.
+ */
+struct YBORM_DECL DmlPlan
+{
+    String sql_;
+    TypeCodes type_codes_;
+    std::vector<int> col_idx_;
+};
+
 class YBORM_DECL Table: NonCopyable
 {
     Table();
@@ -226,24 +238,42 @@ public:
     Table &operator << (Column &c) { add_column(c); c.set_table(*this); return *this; }
     void set_seq_name(const String &seq_name);
     void set_autoinc(bool autoinc) { autoinc_ = autoinc; }
-    void set_name(const String &name) { name_ = name; }
+    void set_name(const String &name) { name_ = name; clear_plans(); }
     void set_xml_name(const String &xml_name) { xml_name_ = xml_name; }
     void set_class_name(const String &class_name) { class_name_ = class_name; }
     void set_depth(int depth) { depth_ = depth; }
+    //! Whether the table has a foreign key to itself, so its rows
+    //! must be ordered by the object graph to be inserted
+    bool self_ref() const;
     const Strings &pk_fields() const { return pk_fields_; }
+    //! Column indexes of pk_fields(), in the same order
+    const std::vector<size_t> &pk_indexes() const { return pk_indexes_; }
     void mk_sample_key(TypeCodes &type_codes, Key &sample_key) const;
     bool mk_key(const Values &row_values, Key &key) const;
     bool mk_key(const Row &row_values, Key &key) const;
+    //! Make the key of the table's columns found in the row at pos
+    bool mk_key(const Row &row_values, size_t pos, Key &key) const;
     const Key mk_key(const Row &row_values) const;
     const Key mk_key(LongInt id) const;
+    //! Find a precompiled DML plan by its key, NULL if not built yet
+    const DmlPlan *find_plan(const String &plan_key) const;
+    //! Store a DML plan, if there is already one with the same key
+    //! then the existing plan is kept and returned
+    const DmlPlan &add_plan(const String &plan_key,
+            const DmlPlan &plan) const;
 private:
+    typedef std::map<String, DmlPlan> DmlPlans;
     String name_, xml_name_, class_name_, seq_name_;
     bool autoinc_;
     Columns cols_;
     IndexMap indicies_;
     Strings pk_fields_;
+    std::vector<size_t> pk_indexes_;
     int depth_;
     Schema *schema_;
+    mutable Mutex plans_mux_;
+    mutable DmlPlans plans_;
+    void clear_plans();
 };
 
 typedef std::vector<Table::Ptr> Tables;
@@ -270,6 +300,9 @@ public:
     }
     const String &attr(int n, const String &name) const;
     const AttrMap &attr_map(int n) const { return n == 0? attr1_: attr2_; }
+    //! How many slave collections are loaded with one query,
+    //! set with the batch-size attribute of the 'many' side
+    int batch_size() const;
     void set_tables(Table *table1, Table *table2) {
         table1_ = table1;
         table2_ = table2;
@@ -284,6 +317,9 @@ public:
     const Strings &fk_fields() const { return fk_fields_; }
     bool eq(const Relation &o);
     Expression join_condition() const;
+    //! The order-by of the 'many' side with bare column names prefixed
+    //! by its table name, to be used in a query joining both tables
+    const String joined_order_by() const;
 private:
     int type_, cascade_;
     String side1_, side2_;
@@ -305,7 +341,7 @@ public:
     typedef std::multimap<String, Relation::Ptr> RelMap;
     typedef Relations RelVect;
 
-    Schema() {}
+    Schema(): depths_filled_(false) {}
     ~Schema();
     Schema &operator=(Schema &x);
     TblMap::const_iterator tbl_begin() const { return tables_.begin(); }
@@ -338,6 +374,13 @@ public:
 
     void fill_fkeys();
     void check_cycles();
+    //! Whether the tables have got their depths, a master table
+    //! being less deep than its slaves, see Table::get_depth()
+    bool depths_filled() const { return depths_filled_; }
+    //! Calculate the depths of the tables without storing them,
+    //! with check = false the foreign keys are not validated
+    //! and the depths of tables in a cycle are arbitrary
+    void calc_depths(std::map<String, int> &depths, bool check = true) const;
 
     // export to text
     void export_ddl(const String &output_file, const String &dialect_name) const;
@@ -345,12 +388,14 @@ public:
 private:
     void clear_backrefs();
     void fix_backrefs();
-    void check_foreign_key(const String &table, const String &fk_table, const String &fk_field);
+    void check_foreign_key(const String &table, const String &fk_table, const String &fk_field) const;
     void set_absolute_depths(const std::map<String, int> &depths);
-    void fill_unique_tables(std::set<String> &unique_tables);
-    void zero_depths(const std::set<String> &unique_tables, std::map<String, int> &depths);
-    void fill_map_tree_by_meta(const std::set<String> &unique_tables, StrMap &tree_map);
-    void traverse_children(const StrMap &parent_child, std::map<String, int> &depths);
+    void fill_unique_tables(std::set<String> &unique_tables) const;
+    void zero_depths(const std::set<String> &unique_tables, std::map<String, int> &depths) const;
+    void fill_map_tree_by_meta(const std::set<String> &unique_tables, StrMap &tree_map,
+            bool check = true) const;
+    void traverse_children(const StrMap &parent_child, std::map<String, int> &depths,
+            bool check = true) const;
     Expression make_join_expr(const Expression &expr1, const String &tbl1,
             Strings::const_iterator it, Strings::const_iterator end) const;
 
@@ -358,6 +403,7 @@ private:
     TblMap tables_;
     RelMap rels_;
     RelVect relations_;
+    bool depths_filled_;
 };
 
 YBORM_DECL const String mk_xml_name(const String &name, const String &xml_name);
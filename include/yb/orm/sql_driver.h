@@ -5,6 +5,7 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include <list>
 #include <map>
 #include <iterator>
 #include "util/utility.h"
@@ -76,10 +77,26 @@ struct ColumnInfo
 
 typedef std::vector<ColumnInfo> ColumnsInfo;
 
+//! How generated keys are obtained after an INSERT statement
+enum SqlInsertedIdModel {
+    INSERTED_ID_PER_ROW,    // one select_last_inserted_id() per row
+    INSERTED_ID_FIRST_ROW,  // the last id refers to the first row in batch
+    INSERTED_ID_LAST_ROW,   // the last id refers to the last row in batch
+    INSERTED_ID_RETURNING   // INSERT ... RETURNING pk
+};
+
 class YBORM_DECL SqlDialect: NonCopyable
 {
     String name_, dual_;
     bool has_sequences_;
+protected:
+    static const String sql_insert_values(const String &table_name,
+            const Strings &columns, const std::vector<Strings> &rows_params);
+    static const String sql_on_conflict_update(const String &table_name,
+            const Strings &columns, const Strings &key_columns,
+            const std::vector<Strings> &rows_params);
+    static const Strings non_key_columns(const Strings &columns,
+            const Strings &key_columns);
 public:
     SqlDialect(const String &name, const String &dual,
             bool has_sequences)
@@ -99,10 +116,20 @@ public:
             const String &seq_name) = 0;
     virtual const String select_last_inserted_id(
             const String &table_name);
+    virtual int inserted_id_model();
     virtual const String sql_value(const Value &x) = 0;
     virtual bool fk_internal();
     virtual bool commit_ddl();
     virtual bool has_for_update();
+    virtual bool has_multirow_insert();
+    virtual bool has_row_value_in();
+    virtual int max_bind_params();
+    //! INSERT that updates the non-key columns of the rows already
+    //! existing, rows_params holds placeholders for each of the rows.
+    //! Empty string means the dialect has no such statement.
+    virtual const String sql_upsert(const String &table_name,
+            const Strings &columns, const Strings &key_columns,
+            const std::vector<Strings> &rows_params);
     virtual const String type2sql(int t) = 0;
     virtual const String create_sequence(const String &seq_name) = 0;
     virtual const String drop_sequence(const String &seq_name) = 0;
@@ -127,11 +154,82 @@ YBORM_DECL SqlDialect *sql_dialect(const String &name);
 YBORM_DECL bool register_sql_dialect(std::auto_ptr<SqlDialect> dialect);
 YBORM_DECL const Strings list_sql_dialects();
 
-typedef std::pair<String, Value> RowItem;
-typedef std::vector<RowItem> Row;
+//! Column names of a result set, computed once per executed statement
+//! and shared by all of its rows.  Names are kept upper case.
+class YBORM_DECL RowHeader: NonCopyable
+{
+    typedef std::map<String, int> Index;
+    Strings names_;
+    Index index_;
+public:
+    RowHeader() {}
+    explicit RowHeader(const Strings &names);
+    void add(const String &name);
+    size_t size() const { return names_.size(); }
+    const String &name(size_t i) const { return names_[i]; }
+    const Strings &names() const { return names_; }
+    //! Index of the column, -1 if there is no such column
+    int find(const String &name) const;
+};
+
+typedef SharedPtr<RowHeader>::Type RowHeaderPtr;
+
+//! A fetched row: a shared column header plus the values
+class YBORM_DECL Row
+{
+    RowHeaderPtr header_;
+    Values values_;
+public:
+    Row() {}
+    explicit Row(const RowHeaderPtr &header);
+    const RowHeaderPtr &header() const { return header_; }
+    size_t size() const { return values_.size(); }
+    bool empty() const { return values_.empty(); }
+    const String &name(size_t i) const { return header_->name(i); }
+    Value &operator[](size_t i) { return values_[i]; }
+    const Value &operator[](size_t i) const { return values_[i]; }
+    Values &values() { return values_; }
+    const Values &values() const { return values_; }
+    //! Attach the row to a header, reusing the storage of the values.
+    //! The values are left as they were, the caller sets each of them.
+    void reset(const RowHeaderPtr &header);
+    //! Index of the column, -1 if there is no such column
+    int find(const String &name) const;
+    //! Value of the column, throws NoDataFound if there is no such column
+    Value &get(const String &name);
+    const Value &get(const String &name) const;
+    void swap(Row &other);
+};
+
+inline void swap(Row &a, Row &b) { a.swap(b); }
+
 typedef std::auto_ptr<Row> RowPtr;
 typedef std::vector<Row> Rows;
 typedef std::auto_ptr<Rows> RowsPtr;
+
+//! A block of rows filled in place by SqlCursor::fetch_block().
+//! The rows once allocated are kept along with their value storage
+//! and reused by the next block.
+class YBORM_DECL RowBlock: NonCopyable
+{
+    Rows rows_;
+    size_t size_;
+public:
+    RowBlock(): size_(0) {}
+    size_t size() const { return size_; }
+    bool empty() const { return !size_; }
+    size_t capacity() const { return rows_.size(); }
+    Row &operator[](size_t i) { return rows_[i]; }
+    const Row &operator[](size_t i) const { return rows_[i]; }
+    void clear() { size_ = 0; }
+    void reserve(size_t n) { if (rows_.size() < n) rows_.resize(n); }
+    //! Take the next row slot, its contents are to be overwritten
+    Row &add_row() {
+        if (size_ == rows_.size())
+            rows_.resize(size_ + 1);
+        return rows_[size_++];
+    }
+};
 typedef std::vector<int> TypeCodes;
 
 class YBORM_DECL SqlCursorBackend: NonCopyable
@@ -143,7 +241,16 @@ public:
     virtual void prepare(const String &sql) = 0;
     virtual void bind_params(const TypeCodes &types);
     virtual void exec(const Values &params) = 0;
+    //! Execute a prepared DML statement for each of the parameter sets,
+    //! the default implementation calls exec() in a loop
+    virtual void exec_many(const std::vector<Values> &params_list);
     virtual RowPtr fetch_row() = 0;
+    //! Fill up to n rows of the block in place, return the number
+    //! of rows fetched, the default implementation calls fetch_row()
+    virtual size_t fetch_block(RowBlock &block, size_t n);
+    virtual bool last_insert_id(LongInt &id);
+    //! Discard pending results, keeping the statement prepared
+    virtual void reset();
 };
 
 class YBORM_DECL SqlSource: public StringDict
@@ -215,10 +322,14 @@ class YBORM_DECL SqlResultSet: public ResultSetBase<Row>
     SqlResultSet(SqlCursor &cursor): cursor_(cursor) {}
 public:
     SqlResultSet(const SqlResultSet &rs)
-        : cursor_(rs.cursor_)
+        : ResultSetBase<Row>(rs.prefetch())
+        , cursor_(rs.cursor_)
         , owned_cursor_(rs.owned_cursor_.release())
     {}
     void own(std::auto_ptr<SqlCursor> cursor);
+    //! Fetch the next rows into the block, bypassing the iterators,
+    //! n = 0 means the row_block() size of the connection
+    size_t fetch_block(RowBlock &block, size_t n = 0);
 };
 
 class YBORM_DECL SqlCursor: NonCopyable
@@ -226,17 +337,27 @@ class YBORM_DECL SqlCursor: NonCopyable
     friend class SqlConnection;
     SqlConnection &connection_;
     std::auto_ptr<SqlCursorBackend> backend_;
+    String sql_;
     bool echo_, conv_params_;
     ILogger *log_;
     void debug(const String &s) { if (log_) log_->debug(NARROW(s)); }
+    void echo_row(const Row *row);
     SqlCursor(SqlConnection &connection);
+    void release_stmt();
 public:
+    ~SqlCursor();
     void exec_direct(const String &sql);
     void prepare(const String &sql);
     void bind_params(const TypeCodes &types);
     SqlResultSet exec(const Values &params);
+    void exec_many(const std::vector<Values> &params_list);
     RowPtr fetch_row();
     RowsPtr fetch_rows(int max_rows = -1); // -1 = all
+    //! Clear the block and fill it with up to n rows,
+    //! n = 0 means the row_block() size of the connection,
+    //! returns the number of rows fetched, 0 at the end
+    size_t fetch_block(RowBlock &block, size_t n = 0);
+    bool last_insert_id(LongInt &id);
 };
 
 class YBORM_DECL SqlConnection: NonCopyable
@@ -249,10 +370,21 @@ class YBORM_DECL SqlConnection: NonCopyable
     std::auto_ptr<SqlConnectionBackend> backend_;
     std::auto_ptr<SqlCursor> cursor_;
     bool activity_, echo_, conv_params_, bad_, explicit_trans_started_;
+    bool consecutive_ids_;
     time_t free_since_;
+    int insert_batch_, delete_batch_, max_bind_params_, stmt_cache_size_;
+    int param_array_, row_block_;
+    typedef std::list<std::pair<String, SqlCursorBackend *> > StmtList;
+    typedef std::map<String, StmtList::iterator> StmtIndex;
+    StmtList stmt_lru_;
+    StmtIndex stmt_index_;
     ILogger::Ptr log_;
     void debug(const String &s) { if (log_.get()) log_->debug(NARROW(s)); }
     void mark_bad(const std::exception &e);
+    void init_options();
+    std::auto_ptr<SqlCursorBackend> take_stmt(const String &sql);
+    bool put_stmt(const String &sql, std::auto_ptr<SqlCursorBackend> &backend);
+    void shrink_stmt_cache(size_t size);
 public:
     SqlConnection(const String &driver_name,
             const String &dialect_name, const String &db,
@@ -269,6 +401,27 @@ public:
     const String &get_user() const { return source_.user(); }
     void set_echo(bool echo) { echo_ = echo; }
     void set_convert_params(bool conv_params) { conv_params_ = conv_params; }
+    //! Max number of rows to put in one multi-row INSERT, 1 = no batching
+    int insert_batch() const { return insert_batch_; }
+    void set_insert_batch(int rows) { insert_batch_ = rows > 1? rows: 1; }
+    //! Trust the server to give consecutive ids to a multi-row INSERT
+    bool consecutive_ids() const { return consecutive_ids_; }
+    void set_consecutive_ids(bool on) { consecutive_ids_ = on; }
+    //! Max number of keys to put in one DELETE ... IN, 1 = no batching
+    int delete_batch() const { return delete_batch_; }
+    void set_delete_batch(int keys) { delete_batch_ = keys > 1? keys: 1; }
+    //! Max number of parameter sets to pass in one exec_many() call
+    int param_array() const { return param_array_; }
+    void set_param_array(int sets) { param_array_ = sets > 1? sets: 1; }
+    //! Number of rows to fetch in one block
+    int row_block() const { return row_block_; }
+    void set_row_block(int rows) { row_block_ = rows > 1? rows: 1; }
+    //! Max number of bound parameters per statement, 0 = no limit
+    int max_bind_params() const { return max_bind_params_; }
+    //! Max number of prepared statements kept for reuse, 0 = no caching
+    int stmt_cache_size() const { return stmt_cache_size_; }
+    void set_stmt_cache_size(int size);
+    size_t stmt_cache_count() const { return stmt_lru_.size(); }
     void init_logger(ILogger *parent) {
         log_.reset(NULL);
         if (parent)
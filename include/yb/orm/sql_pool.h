@@ -7,6 +7,7 @@
 #include "util/thread.h"
 #include "orm_config.h"
 #include "sql_driver.h"
+#include "id_allocator.h"
 
 namespace Yb {
 
@@ -44,6 +45,11 @@ public:
     void add_source(const SqlSource &source);
     SqlConnectionPtr get(const String &id, int timeout = YB_POOL_WAIT_TIME);
     void put(SqlConnectionPtr handle, bool close_now = false, bool new_conn = false);
+    //! Id allocator shared by all the engines drawing from the source
+    IdAllocator *id_allocator(const String &id);
+    //! Replace the allocator, should be done before engines are cloned
+    void set_id_allocator(const String &id,
+            std::auto_ptr<IdAllocator> allocator);
 
 private:
     std::map<String, SqlSource> sources_;
@@ -54,6 +60,8 @@ private:
     std::map<String, OpenErrors> open_errors_;
     std::deque<String> connections_for_open_;
     std::deque<SqlConnectionPtr> connections_for_delete_;
+    typedef std::map<String, IdAllocator *> IdAllocators;
+    IdAllocators id_allocators_;
     Mutex pool_mux_, stop_mux_;
     Condition pool_cond_, stop_cond_;
     int pool_max_size_, idle_time_, monitor_sleep_;
@@ -0,0 +1,87 @@
+// -*- Mode: C++; c-basic-offset: 4; tab-width: 4; indent-tabs-mode: nil; -*-
+#ifndef YB__UTIL__OBJECT_POOL__INCLUDED
+#define YB__UTIL__OBJECT_POOL__INCLUDED
+
+#include <stddef.h>
+#include <vector>
+#include "util_config.h"
+#include "utility.h"
+
+namespace Yb {
+
+//! Arena for small objects of the same owner, like a Session
+/** Memory is taken from the system in chunks and handed out
+ * in blocks of size classes, a multiple of GRANULE bytes each.
+ * A deleted object's block goes to the free list of its class,
+ * the chunks are freed all at once when the pool is gone.
+ * Each live block holds a reference to the pool, so an object
+ * that outlives the owner of the pool keeps the memory valid.
+ * The pool is not thread safe, just like RefCountBase.
+ */
+class YBUTIL_DECL ObjectPool: public RefCountBase, private NonCopyable
+{
+public:
+    typedef IntrusivePtr<ObjectPool> Ptr;
+    enum { GRANULE = 16, N_CLASSES = 32, MAX_BLOCK = GRANULE * N_CLASSES };
+
+    explicit ObjectPool(size_t chunk_size = 64 * 1024);
+    ~ObjectPool();
+    size_t chunk_size() const { return chunk_size_; }
+    size_t chunks() const { return chunks_.size(); }
+    //! Number of blocks handed out and not yet returned
+    size_t used() const { return used_; }
+
+    //! Allocate size bytes from the pool, or from the heap
+    //! if pool is NULL or size is over MAX_BLOCK
+    static void *allocate(ObjectPool *pool, size_t size);
+    //! Return the memory to where it was taken from
+    static void deallocate(void *p);
+private:
+    struct Header
+    {
+        ObjectPool *pool;
+        size_t size_class;
+    };
+    union Block
+    {
+        Header header;
+        // keep the payload aligned as operator new does
+        double align_d;
+        LongInt align_l;
+        void *align_p;
+        char pad[GRANULE];
+    };
+    void *take(size_t size_class);
+    void put(Block *block);
+
+    size_t chunk_size_, used_;
+    std::vector<char *> chunks_;
+    char *cur_, *end_;
+    Block *free_[N_CLASSES];
+};
+
+//! Base for the classes whose instances can be placed in an ObjectPool
+/** new T(...) takes the memory from the heap, new (pool) T(...)
+ * takes it from the pool, and delete works for both.
+ */
+class YBUTIL_DECL PoolObject
+{
+public:
+    static void *operator new(size_t size) {
+        return ObjectPool::allocate(NULL, size);
+    }
+    static void *operator new(size_t size, ObjectPool *pool) {
+        return ObjectPool::allocate(pool, size);
+    }
+    static void operator delete(void *p) {
+        ObjectPool::deallocate(p);
+    }
+    static void operator delete(void *p, ObjectPool *) {
+        ObjectPool::deallocate(p);
+    }
+};
+
+} // namespace Yb
+
+// vim:ts=4:sts=4:sw=4:et:
+#endif // YB__UTIL__OBJECT_POOL__INCLUDED
@@ -2,7 +2,7 @@
 #ifndef YB__UTIL__RESULT_SET__INCLUDED
 #define YB__UTIL__RESULT_SET__INCLUDED
 
-#include <deque>
+#include <vector>
 #include <iterator>
 #include <algorithm>
 #include <cstddef>
@@ -10,48 +10,88 @@
 
 namespace Yb {
 
+//! Exchange two rows, the ADL lookup picks up row types' own swap()
+template <class RowType>
+inline void swap_rows(RowType &a, RowType &b)
+{
+    using std::swap;
+    swap(a, b);
+}
+
+//! Input range over the rows produced by fetch().
+/** The rows are kept in a fixed size ring: the current row, up to
+ * prefetch() rows fetched ahead, and the previous row, which is still
+ * referenced by the result of the postfix increment.  The ring slots are
+ * filled in place by fetch() and reused, rows are never copied.
+ */
 template <class RowType>
 class ResultSetBase
 {
-    std::deque<RowType> rows_;
+    std::vector<RowType> ring_;
+    size_t prefetch_, head_, count_;
     bool finish_;
 
     virtual bool fetch(RowType &row) = 0;
 
-    bool ready() const { return rows_.size() > 1; }
+    size_t slot(size_t i) const { return (head_ + i) % ring_.size(); }
+    bool ready() const { return count_ > 0; }
     RowType &get_current_row() {
         YB_ASSERT(ready());
-        return rows_[1];
+        return ring_[head_];
     }
     RowType &get_previous_row() {
-        YB_ASSERT(!rows_.empty());
-        return rows_[0];
+        YB_ASSERT(!ring_.empty());
+        return ring_[slot(ring_.size() - 1)];
     }
     void step_forward() {
-        YB_ASSERT(!rows_.empty());
-        rows_.pop_front();
+        YB_ASSERT(ready());
+        head_ = slot(1);
+        --count_;
     }
-    bool fetch_next() {
-        if (finish_)
+    void grow(size_t capacity) {
+        std::vector<RowType> ring(capacity);
+        if (!ring_.empty()) {
+            for (size_t i = 0; i < count_; ++i)
+                swap_rows(ring[i], ring_[slot(i)]);
+            swap_rows(ring[capacity - 1], ring_[slot(ring_.size() - 1)]);
+        }
+        ring_.swap(ring);
+        head_ = 0;
+    }
+    bool fetch_one() {
+        if (!fetch(ring_[slot(count_)])) {
+            finish_ = true;
             return false;
-        RowType row;
-        finish_ = !fetch(row);
-        if (!finish_) {
-            if (rows_.empty()) {
-                RowType row0;
-                rows_.push_back(row0);
-            }
-            rows_.push_back(row);
         }
-        return !finish_;
+        ++count_;
+        return true;
+    }
+    bool fetch_next() {
+        if (ring_.size() < prefetch_ + 1)
+            grow(prefetch_ + 1);
+        // the slot before head_ holds the previous row
+        while (!finish_ && count_ < prefetch_ && count_ + 1 < ring_.size())
+            fetch_one();
+        return ready();
     }
 public:
     class iterator;
     friend class iterator;
 
-    ResultSetBase(): finish_(false) {}
+    explicit ResultSetBase(size_t prefetch = 1)
+        : prefetch_(prefetch > 0? prefetch: 1)
+        , head_(0)
+        , count_(0)
+        , finish_(false)
+    {}
     virtual ~ResultSetBase() {}
 
+    size_t prefetch() const { return prefetch_; }
+    //! Set how many rows to fetch ahead when the ring runs empty
+    void set_prefetch(size_t prefetch) {
+        prefetch_ = prefetch > 0? prefetch: 1;
+    }
+
     class iterator: public std::iterator<std::input_iterator_tag,
             RowType, ptrdiff_t, RowType *, RowType & >
     {
@@ -115,9 +155,14 @@ public:
 
     iterator begin() { return iterator(*this, false); }
     iterator end() { return iterator(*this, true); }
+    //! Fetch all the remaining rows, growing the ring as needed
     void load() {
-        while (!finish_)
-            fetch_next();
+        fetch_next();
+        while (!finish_) {
+            if (count_ + 1 >= ring_.size())
+                grow(ring_.size() * 2);
+            fetch_one();
+        }
     }
 };
 
@@ -134,6 +179,20 @@ inline OutputIterator
     return result;
 }
 
+//! Same as copy_no_more_than_n, but the rows are swapped into
+//! the container's new elements instead of being copied.
+template<class InputIterator, class Size, class Container>
+inline void
+    move_no_more_than_n(InputIterator first, InputIterator last,
+                        Size n, Container &result)
+{
+    for (Size count = 0; first != last &&
+             (n < 0? true: count < n); ++first, ++count) {
+        result.push_back(typename Container::value_type());
+        swap_rows(result.back(), *first);
+    }
+}
+
 } // namespace Yb
 
 // vim:ts=4:sts=4:sw=4:et:
@@ -60,45 +60,209 @@ DataObjectAlreadyInSession::DataObjectAlreadyInSession(
                   "in the identity map: ") + key2str(key))
 {}
 
-bool DataObjectResultSet::fetch(ObjectList &row)
+ReadOnlyObject::ReadOnlyObject(const String &table_name)
+    : ORMError(_T("DataObject of table ") + table_name +
+               _T(" is read-only"))
+{}
+
+static bool same_objects(const ObjectList &a, const ObjectList &b)
 {
-    if (!it_.get())
-        it_.reset(new SqlResultSet::iterator(rs_.begin()));
-    if (rs_.end() == *it_)
+    if (a.size() != b.size())
         return false;
-    ObjectList new_row;
-    Row &cur = **it_;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (shptr_get(a[i]) != shptr_get(b[i]))
+            return false;
+    return true;
+}
+
+bool DataObjectResultSet::next_row()
+{
+    if (block_pos_ >= block_.size()) {
+        block_pos_ = 0;
+        if (!rs_.fetch_block(block_))
+            return false;
+        load_select_in();
+    }
+    return true;
+}
+
+void DataObjectResultSet::fill_row(Row &cur, ObjectList &row)
+{
+    row.resize(tables_.size());
     size_t pos = 0;
     for (size_t i = 0; i < tables_.size(); ++i) {
-        DataObject::Ptr d = DataObject::create_new
-            (*tables_[i], DataObject::Sync);
-        pos = d->fill_from_row(cur, pos);
-        DataObject::Ptr e = session_.save_or_update(d);
-        new_row.push_back(e);
+        row[i] = session_.load_from_row(*tables_[i], cur, pos);
+        pos += tables_[i]->size();
+    }
+}
+
+void DataObjectResultSet::load_select_in()
+{
+    Eagers::const_iterator i = eager_.begin(), iend = eager_.end();
+    for (; i != iend; ++i) {
+        if (i->mode != EagerSelectIn)
+            continue;
+        const Table &master_tbl = *tables_[i->master];
+        RelationObject::Batch batch;
+        Key key;
+        for (size_t j = 0; j < block_.size(); ++j) {
+            if (!master_tbl.mk_key(block_[j], i->master_pos, key))
+                continue;
+            DataObject::Ptr master = session_.get_lazy(key);
+            if (master->status() == DataObject::ToBeDeleted ||
+                    master->status() == DataObject::Deleted)
+                continue;
+            RelationObject *ro = master->get_slaves(*i->rel);
+            if (ro->status() == RelationObject::Incomplete &&
+                    std::find(batch.begin(), batch.end(), ro) == batch.end())
+                batch.push_back(ro);
+        }
+        if (!batch.empty())
+            RelationObject::load_slaves(session_, *i->rel, batch);
+    }
+}
+
+void DataObjectResultSet::start_pending(ObjectList &row)
+{
+    pending_.swap(row);
+    pending_ros_.clear();
+    Eagers::const_iterator i = eager_.begin(), iend = eager_.end();
+    for (; i != iend; ++i) {
+        if (i->mode != EagerJoined)
+            continue;
+        // the collections loaded before are left as they are
+        RelationObject *ro = pending_[i->master]->get_slaves(*i->rel);
+        pending_ros_.push_back(
+                ro->status() == RelationObject::Incomplete? ro: NULL);
     }
-    row.swap(new_row);
-    ++*it_;
+}
 
+void DataObjectResultSet::link_joined(Row &cur)
+{
+    size_t k = 0;
+    Key key;
+    Eagers::const_iterator i = eager_.begin(), iend = eager_.end();
+    for (; i != iend; ++i) {
+        if (i->mode != EagerJoined)
+            continue;
+        RelationObject *ro = pending_ros_[k++];
+        const Table &slave_tbl = i->rel->table(1);
+        // NULLs come from LEFT JOIN for a master without slaves
+        if (!ro || !slave_tbl.mk_key(cur, i->slave_pos, key))
+            continue;
+        DataObject::Ptr o = session_.load_from_row(
+                slave_tbl, cur, i->slave_pos);
+        if (o->status() != DataObject::ToBeDeleted
+                && o->status() != DataObject::Deleted)
+            DataObject::link(ro->master_object(), o, *i->rel);
+    }
+}
+
+void DataObjectResultSet::finish_pending(ObjectList &row)
+{
+    std::vector<RelationObject *>::iterator i = pending_ros_.begin(),
+        iend = pending_ros_.end();
+    for (; i != iend; ++i)
+        if (*i)
+            (*i)->status(RelationObject::Sync);
+    pending_ros_.clear();
+    row.swap(pending_);
+    pending_.clear();
+}
+
+bool DataObjectResultSet::fetch(ObjectList &row)
+{
+    if (!joined_) {
+        if (!next_row())
+            return false;
+        fill_row(block_[block_pos_++], row);
+        return true;
+    }
+    // A master is returned once all of its joined slaves are linked,
+    // i.e. when a row of another master comes, or the rows are over.
+    ObjectList cur;
+    while (next_row()) {
+        Row &r = block_[block_pos_++];
+        fill_row(r, cur);
+        if (pending_.empty())
+            start_pending(cur);
+        else if (!same_objects(cur, pending_)) {
+            finish_pending(row);
+            start_pending(cur);
+            link_joined(r);
+            return true;
+        }
+        link_joined(r);
+    }
+    if (pending_.empty())
+        return false;
+    finish_pending(row);
     return true;
 }
 
 DataObjectResultSet::DataObjectResultSet(const SqlResultSet &rs, Session &session,
-                                         const Strings &tables)
+                                         const Strings &tables,
+                                         const EagerList &eager)
     : rs_(rs)
+    , block_pos_(0)
     , session_(session)
+    , joined_(false)
 {
     const Schema &schema = session.schema();
+    std::vector<size_t> offsets;
+    size_t pos = 0;
     Strings::const_iterator i = tables.begin(), iend = tables.end();
-    for (; i != iend; ++i)
+    for (; i != iend; ++i) {
         tables_.push_back(&schema.table(*i));
+        offsets.push_back(pos);
+        pos += tables_.back()->size();
+    }
+    EagerList::const_iterator j = eager.begin(), jend = eager.end();
+    for (; j != jend; ++j) {
+        Eager e;
+        e.rel = j->first;
+        e.mode = j->second;
+        e.master = std::find(tables_.begin(), tables_.end(),
+                             &e.rel->table(0)) - tables_.begin();
+        if (e.master == tables_.size())
+            throw ORMError(_T("Eager loading: master table ") +
+                    e.rel->table(0).name() + _T(" is not selected"));
+        if (session.stateless())
+            throw ORMError(_T("Eager loading: not available "
+                              "in a stateless session"));
+        e.master_pos = offsets[e.master];
+        e.slave_pos = 0;
+        if (e.mode == EagerJoined) {
+            e.slave_pos = pos;
+            pos += e.rel->table(1).size();
+            joined_ = true;
+        }
+        eager_.push_back(e);
+    }
 }
 
 DataObjectResultSet::DataObjectResultSet(const DataObjectResultSet &obj)
-    : rs_(obj.rs_)
+    : ResultSetBase<ObjectList>(obj.prefetch())
+    , rs_(obj.rs_)
+    , block_pos_(0)
     , tables_(obj.tables_)
     , session_(obj.session_)
+    , eager_(obj.eager_)
+    , joined_(obj.joined_)
+{
+    YB_ASSERT(obj.block_.empty());
+    YB_ASSERT(obj.pending_.empty());
+}
+
+// Convert the PK values of the table's columns in the row at pos
+// to the columns' types, to make an ObjectKey of them
+static void fix_key_types(const Table &table, Row &row, size_t pos)
 {
-    YB_ASSERT(!obj.it_.get());
+    const std::vector<size_t> &pk_idx = table.pk_indexes();
+    std::vector<size_t>::const_iterator i = pk_idx.begin(),
+        iend = pk_idx.end();
+    for (; i != iend; ++i)
+        row[pos + *i].fix_type(table[*i].type());
 }
 
 YBORM_DECL const String key2str(const Key &key)
@@ -114,6 +278,73 @@ YBORM_DECL const String key2str(const Key &key)
     return WIDEN(out.str());
 }
 
+void ChangeList::push_back(DataObject *obj)
+{
+    YB_ASSERT(!obj->change_list_);
+    obj->change_list_ = this;
+    obj->prev_changed_ = tail_;
+    obj->next_changed_ = NULL;
+    if (tail_)
+        tail_->next_changed_ = obj;
+    else
+        head_ = obj;
+    tail_ = obj;
+    ++size_;
+}
+
+void ChangeList::remove(DataObject *obj)
+{
+    YB_ASSERT(obj->change_list_ == this);
+    if (obj->prev_changed_)
+        obj->prev_changed_->next_changed_ = obj->next_changed_;
+    else
+        head_ = obj->next_changed_;
+    if (obj->next_changed_)
+        obj->next_changed_->prev_changed_ = obj->prev_changed_;
+    else
+        tail_ = obj->prev_changed_;
+    obj->change_list_ = NULL;
+    obj->prev_changed_ = obj->next_changed_ = NULL;
+    --size_;
+}
+
+void ChangeList::copy_to(std::vector<DataObject *> &out) const
+{
+    out.reserve(out.size() + size_);
+    for (DataObject *obj = head_; obj; obj = obj->next_changed_)
+        out.push_back(obj);
+}
+
+void IncompleteList::push_back(RelationObject *ro)
+{
+    YB_ASSERT(!ro->incomplete_list_);
+    ro->incomplete_list_ = this;
+    ro->prev_incomplete_ = tail_;
+    ro->next_incomplete_ = NULL;
+    if (tail_)
+        tail_->next_incomplete_ = ro;
+    else
+        head_ = ro;
+    tail_ = ro;
+    ++size_;
+}
+
+void IncompleteList::remove(RelationObject *ro)
+{
+    YB_ASSERT(ro->incomplete_list_ == this);
+    if (ro->prev_incomplete_)
+        ro->prev_incomplete_->next_incomplete_ = ro->next_incomplete_;
+    else
+        head_ = ro->next_incomplete_;
+    if (ro->next_incomplete_)
+        ro->next_incomplete_->prev_incomplete_ = ro->prev_incomplete_;
+    else
+        tail_ = ro->prev_incomplete_;
+    ro->incomplete_list_ = NULL;
+    ro->prev_incomplete_ = ro->next_incomplete_ = NULL;
+    --size_;
+}
+
 void Session::clone_engine(EngineSource *src_engine)
 {
     if (src_engine) {
@@ -133,6 +364,9 @@ void Session::set_logger(ILogger::Ptr logger)
 
 Session::Session(const Schema &schema, EngineSource *engine)
     : schema_(schema)
+    , refresh_loaded_(true)
+    , stateless_(false)
+    , ghost_batch_(1)
 {
     clone_engine(engine);
 }
@@ -143,6 +377,9 @@ Session::Session(const Schema &schema, const String &connection_url)
                 new Engine(Engine::READ_WRITE,
                     std::auto_ptr<SqlConnection>(
                         new SqlConnection(connection_url)))))
+    , refresh_loaded_(true)
+    , stateless_(false)
+    , ghost_batch_(1)
 {
     clone_engine(created_engine_.get());
 }
@@ -155,6 +392,9 @@ Session::Session(const Schema &schema, const String &driver_name,
                     std::auto_ptr<SqlConnection>(
                         new SqlConnection(driver_name, dialect_name,
                             raw_connection)))))
+    , refresh_loaded_(true)
+    , stateless_(false)
+    , ghost_batch_(1)
 {
     clone_engine(created_engine_.get());
 }
@@ -168,29 +408,86 @@ void Session::clear()
         (*i)->forget_session();
     Objects empty_objects;
     objects_.swap(empty_objects);
-    IdentityMap empty_map;
-    identity_map_.swap(empty_map);
+    identity_map_.clear();
+    GhostLists empty_ghosts;
+    ghost_objs_.swap(empty_ghosts);
+    IncompleteLists empty_incomplete;
+    incomplete_objs_.swap(empty_incomplete);
+    if (pool_.get())
+        pool_ = ObjectPool::Ptr(new ObjectPool(pool_->chunk_size()));
     if (engine_.get())
         engine_->rollback();
 }
 
+ChangeList *Session::change_list(const DataObject *obj)
+{
+    switch (obj->status_) {
+    case DataObject::Ghost: {
+        ChangeListPtr &list = ghost_objs_[&obj->table_];
+        if (!shptr_get(list))
+            list = ChangeListPtr(new ChangeList);
+        return shptr_get(list);
+    }
+    case DataObject::New:
+        return &new_objs_;
+    case DataObject::Dirty:
+        return &dirty_objs_;
+    case DataObject::ToBeDeleted:
+        return &to_delete_objs_;
+    case DataObject::Deleted:
+        return &deleted_objs_;
+    case DataObject::Sync:
+        // loaded and unchanged, nothing to flush
+        return NULL;
+    }
+    return NULL;
+}
+
+void Session::update_change_list(DataObject *obj)
+{
+    ChangeList *list = change_list(obj);
+    if (list == obj->change_list_)
+        return;
+    if (obj->change_list_)
+        obj->change_list_->remove(obj);
+    if (list)
+        list->push_back(obj);
+}
+
+void Session::update_incomplete_list(RelationObject *ro)
+{
+    IncompleteList *list = NULL;
+    if (ro->status_ == RelationObject::Incomplete) {
+        IncompleteListPtr &p = incomplete_objs_[&ro->relation_info_];
+        if (!shptr_get(p))
+            p = IncompleteListPtr(new IncompleteList);
+        list = shptr_get(p);
+    }
+    if (list == ro->incomplete_list_)
+        return;
+    if (ro->incomplete_list_)
+        ro->incomplete_list_->remove(ro);
+    if (list)
+        list->push_back(ro);
+}
+
 DataObject *Session::add_to_identity_map(DataObject *obj, bool return_found)
 {
     if (obj->assigned_key()) {
-        const String &key = obj->key_str();
-        IdentityMap::iterator i = identity_map_.find(key);
-        if (i != identity_map_.end()) {
+        DataObject *found = identity_map_.insert(obj->object_key(), obj);
+        if (found) {
             if (return_found)
-                return i->second;
+                return found;
             throw DataObjectAlreadyInSession(obj->key());
         }
-        identity_map_[key] = obj;
     }
     return obj;
 }
 
 void Session::save(DataObjectPtr obj0)
 {
+    if (obj0->read_only())
+        throw ReadOnlyObject(obj0->table().name());
     DataObject *obj = add_to_identity_map(shptr_get(obj0), false);
     if (obj == shptr_get(obj0)) {
         objects_.insert(obj0);
@@ -198,8 +495,16 @@ void Session::save(DataObjectPtr obj0)
     }
 }
 
-DataObjectPtr Session::save_or_update(DataObjectPtr obj0)
+DataObjectPtr Session::save_or_update(DataObjectPtr obj0, bool upsert)
 {
+    if (obj0->read_only())
+        throw ReadOnlyObject(obj0->table().name());
+    if (upsert && obj0->status() == DataObject::New) {
+        // an UPSERT can only match an existing row by its key
+        if (!obj0->assigned_key())
+            throw NullPK(obj0->table().name());
+        obj0->set_upsert(true);
+    }
     DataObject *obj = add_to_identity_map(shptr_get(obj0), true);
     if (obj == shptr_get(obj0)) {
         objects_.insert(obj0);
@@ -210,18 +515,16 @@ DataObjectPtr Session::save_or_update(DataObjectPtr obj0)
     for (size_t i = 0; i < table.size(); ++i)
         if (!table[i].is_pk())
             obj->values_[i] = obj0->values_[i];
-    obj->status_ = obj0->status_;
+    obj->set_status(obj0->status_);
+    obj->changed_ = obj0->changed_;
+    obj->upsert_ = obj0->upsert_;
     return DataObjectPtr(obj);
 }
 
 void Session::detach(DataObjectPtr obj)
 {
-    if (obj->assigned_key()) {
-        const String &key = obj->key_str();
-        IdentityMap::iterator i = identity_map_.find(key);
-        if (i != identity_map_.end())
-            identity_map_.erase(i);
-    }
+    if (obj->assigned_key())
+        identity_map_.erase(obj->object_key());
     Objects::iterator i = objects_.find(obj);
     if (i != objects_.end()) {
         objects_.erase(i);
@@ -264,78 +567,202 @@ DataObjectResultSet Session::load_collection(
 }
 
 DataObjectResultSet Session::load_collection(
-        const Strings &tables, const SelectExpr &select_expr)
+        const Strings &tables, const SelectExpr &select_expr,
+        const EagerList &eager)
 {
     SqlResultSet rs = engine_->select_iter(select_expr);
-    return DataObjectResultSet(rs, *this, tables);
+    return DataObjectResultSet(rs, *this, tables, eager);
 }
 
 DataObject::Ptr Session::get_lazy(const Key &key)
 {
-    String key_str = key2str(key);
-    IdentityMap::iterator i = identity_map_.find(key_str);
-    if (i != identity_map_.end())
-        return DataObject::Ptr(i->second);
-    bool empty = empty_key(key);
-    if (empty)
+    if (empty_key(key))
         return DataObject::Ptr(NULL);
-    DataObjectPtr new_obj =
-        DataObject::create_new(schema_[key.first], DataObject::Ghost);
+    // lay the key values out as a row of the table in key_buf_,
+    // so that the probe reuses its storage
+    const Table &table = schema_[key.first];
+    if (key_buf_.size() < table.size())
+        key_buf_.resize(table.size());
+    const std::vector<size_t> &pk_idx = table.pk_indexes();
+    std::vector<size_t>::const_iterator p = pk_idx.begin(),
+        pend = pk_idx.end();
+    for (; p != pend; ++p)
+        key_buf_[*p] = Value();
     ValueMap::const_iterator j = key.second.begin(), jend = key.second.end();
-    for (; j != jend; ++j)
+    for (; j != jend; ++j) {
+        size_t idx = table.idx_by_name(j->first);
+        key_buf_[idx] = j->second;
+        key_buf_[idx].fix_type(table[idx].type());
+    }
+    ObjectKey obj_key(table, &key_buf_[0]);
+    DataObject *found = identity_map_.find(obj_key);
+    if (found)
+        return DataObject::Ptr(found);
+    DataObjectPtr new_obj =
+        DataObject::create_new(table, DataObject::Ghost, object_pool());
+    for (j = key.second.begin(); j != jend; ++j)
         new_obj->set(j->first, j->second);
     objects_.insert(new_obj);
     new_obj->set_session(this);
-    identity_map_[key_str] = shptr_get(new_obj);
+    if (new_obj->assigned_key())
+        identity_map_.insert(new_obj->object_key(), shptr_get(new_obj));
     return new_obj;
 }
 
-typedef std::map<String, Rows> RowsByTable;
-typedef std::map<String, RowsData> RowsDataByTable;
+ObjectList Session::get_many(const Keys &keys, size_t batch)
+{
+    typedef std::map<const Table *, std::vector<DataObject *> > Ghosts;
+    Ghosts ghosts;
+    ObjectList objs;
+    objs.reserve(keys.size());
+    Keys::const_iterator i = keys.begin(), iend = keys.end();
+    for (; i != iend; ++i) {
+        DataObject::Ptr obj = get_lazy(*i);
+        objs.push_back(obj);
+        if (shptr_get(obj) && obj->status() == DataObject::Ghost)
+            ghosts[&obj->table()].push_back(shptr_get(obj));
+    }
+    if (batch < 1)
+        batch = 1;
+    Ghosts::const_iterator j = ghosts.begin(), jend = ghosts.end();
+    for (; j != jend; ++j) {
+        for (size_t pos = 0; pos < j->second.size(); pos += batch) {
+            size_t end = std::min(pos + batch, j->second.size());
+            std::vector<DataObject *> chunk(j->second.begin() + pos,
+                                            j->second.begin() + end);
+            load_ghosts(*j->first, chunk);
+        }
+    }
+    return objs;
+}
 
-template <class Row__, class Rows__>
-void add_row_to_rows_by_table(std::map<String, Rows__> &rows_by_table,
-                              const String &tbl_name, const Row__ &row)
+void Session::add_ghosts(const Table &table, size_t n,
+                         std::vector<DataObject *> &batch)
 {
-    typename std::map<String, Rows__>::iterator k = rows_by_table.find(tbl_name);
-    if (k == rows_by_table.end()) {
-        Rows__ rows(1);
-        rows[0] = row;
-        rows_by_table.insert(std::make_pair(tbl_name, rows));
+    GhostLists::const_iterator l = ghost_objs_.find(&table);
+    if (l == ghost_objs_.end())
+        return;
+    // skip the Ghosts given in batch, the list has no duplicates
+    size_t given = batch.size();
+    DataObject *obj = l->second->head();
+    for (; obj && batch.size() < n; obj = obj->next_changed_)
+        if (std::find(batch.begin(), batch.begin() + given, obj)
+                == batch.begin() + given)
+            batch.push_back(obj);
+}
+
+void Session::load_ghosts(const Table &table,
+                          const std::vector<DataObject *> &ghosts)
+{
+    IdentityMap by_key;
+    Keys keys;
+    keys.reserve(ghosts.size());
+    std::vector<DataObject *>::const_iterator i = ghosts.begin(),
+        iend = ghosts.end();
+    for (; i != iend; ++i) {
+        keys.push_back((*i)->key());
+        by_key.insert((*i)->object_key(), *i);
     }
-    else {
-        Rows__ &rows = k->second;
-        rows.push_back(row);
+    ExpressionList cols;
+    Columns::const_iterator j = table.begin(), jend = table.end();
+    for (; j != jend; ++j)
+        cols << ColumnExpr(table.name(), j->name());
+    SqlResultSet rs = engine_->select_iter(SelectExpr(cols)
+            .from_(Expression(table.name())).where_(filter_keys(keys)));
+    SqlResultSet::iterator k = rs.begin(), kend = rs.end();
+    for (; k != kend; ++k) {
+        fix_key_types(table, *k, 0);
+        DataObject *found = by_key.find(ObjectKey(table, &(*k)[0]));
+        if (found && found->status() == DataObject::Ghost)
+            found->fill_from_row(*k);
+    }
+}
+
+DataObject::Ptr Session::load_from_row(const Table &table,
+                                      Row &row, size_t pos)
+{
+    if (stateless_) {
+        DataObject::Ptr obj = DataObject::create_new(
+                table, DataObject::Sync, object_pool());
+        obj->fill_from_row(row, pos);
+        obj->read_only_ = true;
+        return obj;
+    }
+    fix_key_types(table, row, pos);
+    ObjectKey key(table, &row[pos]);
+    if (key.assigned()) {
+        DataObject *obj = identity_map_.find(key);
+        if (obj) {
+            if (refresh_loaded_ || obj->status() == DataObject::Ghost)
+                obj->fill_from_row(row, pos);
+            return DataObject::Ptr(obj);
+        }
     }
+    DataObject::Ptr obj = DataObject::create_new(
+            table, DataObject::Sync, object_pool());
+    obj->fill_from_row(row, pos);
+    return save_or_update(obj);
 }
 
-void Session::flush_tbl_new_keyed(const Table &tbl, Objects &keyed_objs)
+void Session::add_incomplete_slaves(const Relation &r, size_t n,
+                                    std::vector<RelationObject *> &batch)
+{
+    IncompleteLists::const_iterator l = incomplete_objs_.find(&r);
+    if (l == incomplete_objs_.end())
+        return;
+    // only the relation objects given in batch, usually just the one
+    // being loaded, can come again from the list
+    size_t given = batch.size();
+    RelationObject *ro = l->second->head();
+    for (; ro && batch.size() < n; ro = ro->next_incomplete_) {
+        int status = ro->master_object_->status();
+        if (status == DataObject::New || status == DataObject::ToBeDeleted
+                || status == DataObject::Deleted)
+            continue;
+        if (std::find(batch.begin(), batch.begin() + given, ro)
+                == batch.begin() + given)
+            batch.push_back(ro);
+    }
+}
+
+void Session::flush_tbl_new_keyed(const Table &tbl,
+        std::vector<DataObject *> &keyed_objs)
 {
     bool sql_seq = engine_->get_dialect()->has_sequences();
     bool use_autoinc = !sql_seq &&
         (tbl.autoinc() || !str_empty(tbl.seq_name()));
-    RowsData rows;
+    RowsData rows, upsert_rows;
     rows.reserve(keyed_objs.size());
-    Objects::iterator i, iend = keyed_objs.end();
+    std::vector<DataObject *>::iterator i, iend = keyed_objs.end();
     for (i = keyed_objs.begin(); i != iend; ++i) {
         (*i)->refresh_master_fkeys();
-        rows.push_back(&(*i)->raw_values());
-        add_to_identity_map(shptr_get(*i), true);
+        if ((*i)->upsert())
+            upsert_rows.push_back(&(*i)->raw_values());
+        else
+            rows.push_back(&(*i)->raw_values());
+        add_to_identity_map(*i, true);
     }
     engine_->insert(tbl, rows, false);
+    engine_->upsert(tbl, upsert_rows);
+    for (i = keyed_objs.begin(); i != iend; ++i)
+        (*i)->set_upsert(false);
 }
 
-void Session::flush_tbl_new_unkeyed(const Table &tbl, Objects &unkeyed_objs)
+void Session::flush_tbl_new_unkeyed(const Table &tbl,
+        std::vector<DataObject *> &unkeyed_objs)
 {
-    bool sql_seq = engine_->get_dialect()->has_sequences();
+    SqlDialect *dialect = engine_->get_dialect();
+    bool sql_seq = dialect->has_sequences();
     bool use_seq = sql_seq && !str_empty(tbl.seq_name());
-    bool use_autoinc = !sql_seq &&
+    // with INSERT ... RETURNING generated keys come back with the insert
+    bool use_autoinc = !use_seq && (!sql_seq ||
+            dialect->inserted_id_model() == INSERTED_ID_RETURNING) &&
         (tbl.autoinc() || !str_empty(tbl.seq_name()));
-    Objects::iterator i, iend = unkeyed_objs.end();
+    std::vector<DataObject *>::iterator i, iend = unkeyed_objs.end();
     if (use_seq) {
         String pk = tbl.get_surrogate_pk();
         for (i = unkeyed_objs.begin(); i != iend; ++i)
-            (*i)->set(pk, Value(engine_->get_next_value(tbl.seq_name())));
+            (*i)->set(pk, Value(engine_->allocate_id(tbl.seq_name())));
     }
     RowsData rows;
     rows.reserve(unkeyed_objs.size());
@@ -354,104 +781,123 @@ void Session::flush_tbl_new_unkeyed(const Table &tbl, Objects &unkeyed_objs)
     // add flushed objects to the identity_map_
     for (i = unkeyed_objs.begin(); i != iend; ++i) {
         (*i)->refresh_slaves_fkeys();
-        add_to_identity_map(shptr_get(*i), false);
+        add_to_identity_map(*i, false);
+    }
+}
+
+void Session::flush_tbl_new(const Table &tbl,
+        const std::vector<DataObject *> &objs)
+{
+    std::vector<DataObject *> keyed_objs, unkeyed_objs;
+    std::vector<DataObject *>::const_iterator i = objs.begin(),
+        iend = objs.end();
+    for (; i != iend; ++i) {
+        if ((*i)->assigned_key())
+            keyed_objs.push_back(*i);
+        else
+            unkeyed_objs.push_back(*i);
     }
+    flush_tbl_new_keyed(tbl, keyed_objs);
+    flush_tbl_new_unkeyed(tbl, unkeyed_objs);
 }
 
 void Session::flush_new()
 {
-    SqlDialect *dialect = engine_->get_dialect();
-    bool sql_seq = dialect->has_sequences();
-    Objects::iterator i = objects_.begin(), iend = objects_.end();
-    for (; i != iend; ++i)
-        if ((*i)->status() == DataObject::New)
-            (*i)->depth(-1);
-    for (i = objects_.begin(); i != iend; ++i)
-        if ((*i)->status() == DataObject::New)
-            (*i)->calc_depth(0);
-    int max_depth = -1;
-    typedef std::map<String, Objects> ObjectsByTable;
-    typedef std::map<int, ObjectsByTable> GroupsByDepth;
-    GroupsByDepth groups_by_depth;
-    for (i = objects_.begin(); i != iend; ++i)
-        if ((*i)->status() == DataObject::New)
-    {
-        int d = (*i)->depth();
-        if (d > max_depth)
-            max_depth = d;
-        GroupsByDepth::iterator k = groups_by_depth.find(d);
-        if (groups_by_depth.end() == k) {
-            std::pair<GroupsByDepth::iterator, bool> res =
-                groups_by_depth.insert(std::make_pair(
-                            d, ObjectsByTable()));
-            k = res.first;
-        }
-        ObjectsByTable &objs_by_table = k->second;
-        const String &tbl_name = (*i)->table().name();
-        ObjectsByTable::iterator q = objs_by_table.find(tbl_name);
-        if (objs_by_table.end() == q) {
-            std::pair<ObjectsByTable::iterator, bool> res =
-                objs_by_table.insert(std::make_pair(
-                            tbl_name, Objects()));
-            q = res.first;
-        }
-        Objects &objs = q->second;
-        objs.insert(*i);
+    std::vector<DataObject *> new_objs;
+    new_objs_.copy_to(new_objs);
+    // the tables go by their depths in the schema, masters first;
+    // if the schema has not got them they are calculated here
+    std::map<String, int> schema_depths;
+    bool depths_filled = schema_.depths_filled();
+    if (!depths_filled)
+        schema_.calc_depths(schema_depths, false);
+    typedef std::vector<DataObject *> ObjectsVec;
+    typedef std::map<const Table *, ObjectsVec> ObjectsByTable;
+    std::vector<ObjectsByTable> by_depth;
+    ObjectsVec::iterator i = new_objs.begin(), iend = new_objs.end();
+    for (; i != iend; ++i) {
+        const Table &tbl = (*i)->table();
+        size_t d = depths_filled? tbl.get_depth():
+            schema_depths[tbl.name()];
+        if (d >= by_depth.size())
+            by_depth.resize(d + 1);
+        by_depth[d][&tbl].push_back(*i);
     }
-    for (int d = 0; d <= max_depth; ++d) {
-        GroupsByDepth::iterator k = groups_by_depth.find(d);
-        if (k == groups_by_depth.end())
-            continue;
-        ObjectsByTable &objs_by_table = k->second;
-        ObjectsByTable::iterator j = objs_by_table.begin(), jend = objs_by_table.end();
-        for (; j != jend; ++j) {
-            const Table &tbl = schema_[j->first];
-            Objects &objs = j->second, unkeyed_objs, keyed_objs;
-            Objects::iterator l, lend = objs.end();
-            for (l = objs.begin(); l != lend; ++l) {
-                if ((*l)->assigned_key())
-                    keyed_objs.insert(*l);
-                else
-                    unkeyed_objs.insert(*l);
+    std::vector<ObjectsByTable>::iterator j = by_depth.begin(),
+        jend = by_depth.end();
+    for (; j != jend; ++j) {
+        ObjectsByTable::iterator k = j->begin(), kend = j->end();
+        for (; k != kend; ++k) {
+            const Table &tbl = *k->first;
+            ObjectsVec &objs = k->second;
+            if (!tbl.self_ref()) {
+                flush_tbl_new(tbl, objs);
+                continue;
+            }
+            // rows of a self-referencing table go by their depth
+            // in the object graph, masters first
+            DataObject::TableDepths obj_depths;
+            for (i = objs.begin(); i != objs.end(); ++i)
+                (*i)->calc_table_depth(0, (int)objs.size(), obj_depths);
+            std::vector<ObjectsVec> by_obj_depth;
+            for (i = objs.begin(); i != objs.end(); ++i) {
+                size_t d = obj_depths[*i];
+                if (d >= by_obj_depth.size())
+                    by_obj_depth.resize(d + 1);
+                by_obj_depth[d].push_back(*i);
             }
-            flush_tbl_new_keyed(tbl, keyed_objs);
-            flush_tbl_new_unkeyed(tbl, unkeyed_objs);
+            std::vector<ObjectsVec>::iterator l = by_obj_depth.begin(),
+                lend = by_obj_depth.end();
+            for (; l != lend; ++l)
+                if (!l->empty())
+                    flush_tbl_new(tbl, *l);
         }
     }
-    for (i = objects_.begin(); i != iend; ++i)
+    for (i = new_objs.begin(); i != iend; ++i)
         if ((*i)->status() == DataObject::New)
             (*i)->set_status(DataObject::Ghost);
 }
 
-void Session::flush_update(IdentityMap &idmap_copy)
+void Session::flush_update()
 {
-    RowsDataByTable rows_by_table;
-    IdentityMap::iterator i = idmap_copy.begin(), iend = idmap_copy.end();
+    // group rows by table and by the set of changed columns
+    typedef std::pair<String, ColumnMask> TableColumns;
+    typedef std::map<TableColumns, RowsData> RowsDataByColumns;
+    RowsDataByColumns rows_by_columns;
+    std::vector<DataObject *> dirty_objs;
+    dirty_objs_.copy_to(dirty_objs);
+    std::vector<DataObject *>::iterator i = dirty_objs.begin(),
+        iend = dirty_objs.end();
     for (; i != iend; ++i)
-        if (i->second->status() == DataObject::Dirty) {
-            const String &tbl_name = i->second->table().name();
-            i->second->refresh_master_fkeys();
-            add_row_to_rows_by_table(rows_by_table, tbl_name,
-                                     &i->second->raw_values());
-            i->second->set_status(DataObject::Ghost);
+        if ((*i)->status() == DataObject::Dirty) {
+            (*i)->refresh_master_fkeys();
+            TableColumns tbl_cols((*i)->table().name(),
+                                  (*i)->changed_columns());
+            rows_by_columns[tbl_cols].push_back(&(*i)->raw_values());
+            (*i)->set_status(DataObject::Ghost);
         }
-    RowsDataByTable::iterator j = rows_by_table.begin(), jend = rows_by_table.end();
+    RowsDataByColumns::iterator j = rows_by_columns.begin(),
+        jend = rows_by_columns.end();
     for (; j != jend; ++j)
-        engine_->update(schema_[j->first], j->second);
+        engine_->update(schema_[j->first.first], j->second,
+                        j->first.second);
 }
 
-void Session::flush_delete(IdentityMap &idmap_copy)
+void Session::flush_delete()
 {
     typedef std::vector<Key> Keys;
     typedef std::map<String, Keys> KeysByTable;
     typedef std::map<int, KeysByTable> GroupsByDepth;
     int max_depth = -1;
     GroupsByDepth groups_by_depth;
-    IdentityMap::iterator i = idmap_copy.begin(), iend = idmap_copy.end();
+    std::vector<DataObject *> to_delete_objs;
+    to_delete_objs_.copy_to(to_delete_objs);
+    std::vector<DataObject *>::iterator i = to_delete_objs.begin(),
+        iend = to_delete_objs.end();
     for (; i != iend; ++i)
-        if (i->second->status() == DataObject::ToBeDeleted)
+        if ((*i)->status() == DataObject::ToBeDeleted)
     {
-        int d = i->second->depth();
+        int d = (*i)->depth();
         if (d > max_depth)
             max_depth = d;
         GroupsByDepth::iterator k = groups_by_depth.find(d);
@@ -462,7 +908,7 @@ void Session::flush_delete(IdentityMap &idmap_copy)
             k = res.first;
         }
         KeysByTable &keys_by_table = k->second;
-        const String &tbl_name = i->second->table().name();
+        const String &tbl_name = (*i)->table().name();
         KeysByTable::iterator q = keys_by_table.find(tbl_name);
         if (keys_by_table.end() == q) {
             std::pair<KeysByTable::iterator, bool> res =
@@ -471,8 +917,8 @@ void Session::flush_delete(IdentityMap &idmap_copy)
             q = res.first;
         }
         Keys &keys = q->second;
-        keys.push_back(i->second->key());
-        i->second->set_status(DataObject::Deleted);
+        keys.push_back((*i)->key());
+        (*i)->set_status(DataObject::Deleted);
     }
 
     for (int d = max_depth; d >= 0; --d) {
@@ -494,20 +940,20 @@ void Session::flush()
 {
     debug(_T("flush started"));
     try {
-        IdentityMap idmap_copy = identity_map_;
         flush_new();
-        flush_update(idmap_copy);
-        flush_delete(idmap_copy);
+        flush_update();
+        flush_delete();
         // Delete the deleted objects
-        Objects obj_copy = objects_;
-        Objects::iterator i = obj_copy.begin(), iend = obj_copy.end();
-        for (; i != iend; ++i)
-            if ((*i)->status() == DataObject::Deleted) {
-                IdentityMap::iterator k = identity_map_.find((*i)->key_str());
-                if (k != identity_map_.end())
-                    identity_map_.erase(k);
-                objects_.erase(objects_.find(*i));
-            }
+        std::vector<DataObject *> deleted_objs;
+        deleted_objs_.copy_to(deleted_objs);
+        std::vector<DataObject *>::iterator i = deleted_objs.begin(),
+            iend = deleted_objs.end();
+        for (; i != iend; ++i) {
+            deleted_objs_.remove(*i);
+            if ((*i)->assigned_key())
+                identity_map_.erase((*i)->object_key());
+            objects_.erase(objects_.find(DataObjectPtr(*i)));
+        }
         debug(_T("flush finished OK"));
     }
     catch (...) {
@@ -531,19 +977,45 @@ void Session::rollback()
 void DataObject::set_session(Session *session)
 {
     YB_ASSERT(session && (!session_ || session_ == session));
-    session_ = session;
+    if (!session_) {
+        session_ = session;
+        session_->update_change_list(this);
+        MasterRelations::iterator i = master_relations_.begin(),
+            iend = master_relations_.end();
+        for (; i != iend; ++i)
+            session_->update_incomplete_list(shptr_get(i->second));
+    }
 }
 
 void DataObject::forget_session()
 {
     YB_ASSERT(session_);
+    if (change_list_)
+        change_list_->remove(this);
+    MasterRelations::iterator i = master_relations_.begin(),
+        iend = master_relations_.end();
+    for (; i != iend; ++i)
+        if (i->second->incomplete_list_)
+            i->second->incomplete_list_->remove(shptr_get(i->second));
     session_ = NULL;
 }
 
 void DataObject::touch()
 {
-    if (status_ == Sync)
-        status_ = Dirty;
+    if (status_ == Sync || status_ == Dirty) {
+        set_status(Dirty);
+        changed_.assign(values_.size(), true);
+    }
+}
+
+void DataObject::touch(int i)
+{
+    if (status_ == Sync || status_ == Dirty) {
+        set_status(Dirty);
+        if (changed_.empty())
+            changed_.resize(values_.size());
+        changed_[i] = true;
+    }
 }
     
 void DataObject::set(int i, const Value &v)
@@ -558,6 +1030,8 @@ void DataObject::set(int i, const Value &v)
     new_v.fix_type(c.type());
     if (values_[i] == new_v)
         return;
+    if (read_only_)
+        throw ReadOnlyObject(table_.name());
     if (!c.is_pk() && c.is_ro())
         throw ReadOnlyColumn(table_.name(), c.name());
     if (c.is_pk() && session_ != NULL && !values_[i].is_null())
@@ -571,50 +1045,51 @@ void DataObject::set(int i, const Value &v)
     if (c.is_pk())
         update_key();
     else
-        touch();
+        touch(i);
 }
 
 void DataObject::update_key()
 {
-    assigned_key_ = table_.mk_key(values_, key_);
-    key_str_ = key2str(key_);
+    // the Key and its string are only built when asked for
+    Key empty_key;
+    key_.swap(empty_key);
+    key_str_ = String();
 }
 
 const Key &DataObject::key()
 {
     if (str_empty(key_.first))
-        update_key();
+        table_.mk_key(values_, key_);
     return key_;
 }
 
 const String &DataObject::key_str()
 {
-    if (str_empty(key_.first))
-        update_key();
+    if (str_empty(key_str_))
+        key_str_ = key2str(key());
     return key_str_;
 }
 
 bool DataObject::assigned_key()
 {
-    if (str_empty(key_.first))
-        update_key();
-    return assigned_key_;
+    const std::vector<size_t> &pk_idx = table_.pk_indexes();
+    std::vector<size_t>::const_iterator i = pk_idx.begin(),
+        iend = pk_idx.end();
+    for (; i != iend; ++i)
+        if (values_[*i].is_null())
+            return false;
+    return true;
 }
 
 void DataObject::load()
 {
     YB_ASSERT(session_ != NULL);
-    ExpressionList cols;
-    Columns::const_iterator it = table_.begin(), end = table_.end();
-    for (; it != end; ++it)
-        cols << ColumnExpr(table_.name(), it->name());
-    KeyFilter f(key());
-    RowsPtr result = session_->engine()->select
-        (cols, Expression(table_.name()), f);
-    if (result->size() != 1)
+    std::vector<DataObject *> batch(1, this);
+    session_->add_ghosts(table_, session_->ghost_batch(), batch);
+    session_->load_ghosts(table_, batch);
+    if (status_ == Ghost)
         throw ObjectNotFoundByKey(table_.name() + _T("(")
-                                  + f.get_sql() + _T(")"));
-    fill_from_row(*result->begin());
+                                  + KeyFilter(key()).get_sql() + _T(")"));
 }
 
 void DataObject::calc_depth(int d, DataObject *parent)
@@ -628,6 +1103,24 @@ void DataObject::calc_depth(int d, DataObject *parent)
     }
 }
 
+void DataObject::calc_table_depth(int d, int max_depth, TableDepths &depths)
+{
+    if (status_ != New)
+        return;
+    // depth_ is left alone, flush_delete() relies on it
+    TableDepths::iterator j = depths.find(this);
+    if (j != depths.end() && j->second >= d)
+        return;
+    if (d > max_depth)
+        throw CycleDetected();
+    depths[this] = d;
+    MasterRelations::iterator i = master_relations_.begin(),
+        iend = master_relations_.end();
+    for (; i != iend; ++i)
+        if (&i->first->table(1) == &table_)
+            i->second->calc_table_depth(d + 1, max_depth, depths);
+}
+
 void DataObject::link(DataObject *master, DataObject::Ptr slave,
                       const Relation &r)
 {
@@ -649,7 +1142,8 @@ void DataObject::link(DataObject *master, DataObject::Ptr slave,
     }
     // Create one if it doesn't exist, master will own it
     if (!ro) {
-        RelationObject::Ptr new_ro = RelationObject::create_new(r, master);
+        RelationObject::Ptr new_ro = RelationObject::create_new(r, master,
+                master->session()? master->session()->object_pool(): NULL);
         master->master_relations().insert(std::make_pair(&r, new_ro));
         ro = shptr_get(new_ro);
     }
@@ -735,7 +1229,8 @@ RelationObject *DataObject::get_slaves(const Relation &r)
         ro = shptr_get(j->second);
     // Create one if it doesn't exist, master will own it
     if (!ro) {
-        RelationObject::Ptr new_ro = RelationObject::create_new(r, this);
+        RelationObject::Ptr new_ro = RelationObject::create_new(r, this,
+                session_? session_->object_pool(): NULL);
         master_relations_.insert(std::make_pair(&r, new_ro));
         ro = shptr_get(new_ro);
     }
@@ -784,11 +1279,11 @@ size_t DataObject::fill_from_row(Row &r, size_t pos)
 {
     size_t i = 0;
     for (; i < table_.size(); ++i) {
-        values_[i].swap(r[pos + i].second);
+        values_[i].swap(r[pos + i]);
         values_[i].fix_type(table_[i].type());
     }
     update_key();
-    status_ = Sync;
+    set_status(Sync);
     return pos + i;
 }
 
@@ -812,6 +1307,8 @@ void DataObject::delete_object(DeletionMode mode, int depth)
 {
     if (status_ == ToBeDeleted || status_ == Deleted)
         return;
+    if (read_only_)
+        throw ReadOnlyObject(table_.name());
     if (mode != DelUnchecked) {
         populate_all_master_relations();
     }
@@ -829,11 +1326,11 @@ void DataObject::delete_object(DeletionMode mode, int depth)
         delete_master_relations(DelUnchecked, depth + 1);
         exclude_from_slave_relations();
         if (status_ == New) {
-            status_ = Deleted;
+            set_status(Deleted);
         }
         else {
             //depth_ = depth; // why the hell I did that?
-            status_ = ToBeDeleted;
+            set_status(ToBeDeleted);
         }
     }
 }
@@ -887,6 +1384,20 @@ void DataObject::dump_tree(std::ostream &out, int level)
         i->second->dump_tree(out, level + 1);
 }
 
+RelationObject::~RelationObject()
+{
+    if (incomplete_list_)
+        incomplete_list_->remove(this);
+}
+
+void RelationObject::update_incomplete_list()
+{
+    if (master_object_ && master_object_->session())
+        master_object_->session()->update_incomplete_list(this);
+    else if (incomplete_list_)
+        incomplete_list_->remove(this);
+}
+
 void RelationObject::add_slave(DataObject::Ptr slave)
 {
     std::pair<SlaveObjectsOrder::iterator, bool> r =
@@ -915,6 +1426,15 @@ RelationObject::SlaveObjects::iterator RelationObject::find(DataObject *obj)
     return slave_objects_.begin() + it->second;
 }
 
+void RelationObject::calc_table_depth(int d, int max_depth,
+        DataObject::TableDepths &depths)
+{
+    SlaveObjects::iterator i = slave_objects_.begin(),
+        iend = slave_objects_.end();
+    for (; i != iend; ++i)
+        (*i)->calc_table_depth(d, max_depth, depths);
+}
+
 void RelationObject::calc_depth(int d, DataObject *parent)
 {
     SlaveObjects::iterator i = slave_objects_.begin(),
@@ -986,7 +1506,7 @@ size_t RelationObject::count_slaves()
     if (result->size() != 1)
         throw ObjectNotFoundByKey(_T("COUNT(*) FOR ") + slave_tbl.name()
                 + _T("(") + f.get_sql() + _T(")"));
-    return static_cast<int>(result->begin()->begin()->second.as_longint());
+    return static_cast<int>((*result->begin())[0].as_longint());
 }
 
 void RelationObject::lazy_load_slaves()
@@ -995,32 +1515,72 @@ void RelationObject::lazy_load_slaves()
         return;
     YB_ASSERT(master_object_->session());
     Session &session = *master_object_->session();
-    const Table &master_tbl = relation_info_.table(0),
-        &slave_tbl = relation_info_.table(1);
+    Batch batch(1, this);
+    int batch_size = relation_info_.batch_size();
+    if (batch_size > 1)
+        session.add_incomplete_slaves(relation_info_, batch_size, batch);
+    load_slaves(session, relation_info_, batch);
+}
+
+void RelationObject::load_slaves(Session &session, const Relation &r,
+                                 const Batch &batch)
+{
+    const Table &master_tbl = r.table(0), &slave_tbl = r.table(1);
+    const Strings &parts = r.fk_fields();
+    IdentityMap masters;
+    Keys fkeys;
+    fkeys.reserve(batch.size());
+    Batch::const_iterator i = batch.begin(), iend = batch.end();
+    for (; i != iend; ++i) {
+        fkeys.push_back((*i)->gen_fkey());
+        masters.insert((*i)->master_object_->object_key(),
+                       (*i)->master_object_);
+    }
+    // foreign key values of a row, typed as the master's primary key
+    std::vector<size_t> fk_idx;
+    Strings::const_iterator p = parts.begin(), pend = parts.end();
+    for (; p != pend; ++p)
+        fk_idx.push_back(slave_tbl.idx_by_name(*p));
+    Values fk_values(fk_idx.size());
     ExpressionList cols;
     Columns::const_iterator j = slave_tbl.begin(), jend = slave_tbl.end();
     for (; j != jend; ++j)
         cols << ColumnExpr(slave_tbl.name(), j->name());
     SelectExpr select_expr = SelectExpr(cols)
         .from_(Expression(slave_tbl.name()))
-        .where_(KeyFilter(gen_fkey()));
-    if (relation_info_.has_attr(1, _T("order-by")) &&
-            !str_empty(relation_info_.attr(1, _T("order-by"))))
+        .where_(filter_keys(fkeys));
+    if (r.has_attr(1, _T("order-by")) &&
+            !str_empty(r.attr(1, _T("order-by"))))
         select_expr.order_by_(
-                Expression(relation_info_.attr(1, _T("order-by"))));
+                Expression(r.attr(1, _T("order-by"))));
     SqlResultSet rs = session.engine()->select_iter(select_expr);
     SqlResultSet::iterator k = rs.begin(), kend = rs.end();
     for (; k != kend; ++k) {
+        RelationObject *ro = batch[0];
+        if (batch.size() > 1) {
+            // find the master by the foreign key
+            const std::vector<size_t> &pk_idx = master_tbl.pk_indexes();
+            for (size_t q = 0; q < fk_idx.size() && q < pk_idx.size(); ++q) {
+                fk_values[q] = (*k)[fk_idx[q]];
+                fk_values[q].fix_type(master_tbl[pk_idx[q]].type());
+            }
+            DataObject *master = masters.find(
+                    ObjectKey::packed(master_tbl, &fk_values[0]));
+            if (!master)
+                continue;
+            ro = master->get_slaves(r);
+        }
         Key pkey;
-        bool assigned_key = slave_tbl.mk_key(*k, pkey);
+        slave_tbl.mk_key(*k, pkey);
         DataObject::Ptr o = session.get_lazy(pkey);
         if (o->status() == DataObject::Ghost)
             o->fill_from_row(*k);
         if (o->status() != DataObject::ToBeDeleted
                 && o->status() != DataObject::Deleted)
-            DataObject::link(master_object_, o, relation_info_);
+            DataObject::link(ro->master_object_, o, r);
     }
-    status_ = Sync;
+    for (i = batch.begin(); i != iend; ++i)
+        (*i)->status(Sync);
 }
 
 void RelationObject::refresh_slaves_fkeys()
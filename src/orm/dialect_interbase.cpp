@@ -70,6 +70,20 @@ InterbaseDialect::pager_model()
     return (int)PAGER_INTERBASE; 
 }
 
+const String
+InterbaseDialect::sql_upsert(const String &table_name,
+        const Strings &columns, const Strings &key_columns,
+        const std::vector<Strings> &rows_params)
+{
+    // Firebird 2.1+, one row per statement
+    if (rows_params.size() != 1)
+        return String();
+    return _T("UPDATE OR INSERT INTO ") + table_name + _T(" (")
+        + ExpressionList(columns).get_sql() + _T(") VALUES (")
+        + ExpressionList(rows_params[0]).get_sql() + _T(") MATCHING (")
+        + ExpressionList(key_columns).get_sql() + _T(")");
+}
+
 // schema introspection
 bool 
 InterbaseDialect::table_exists(SqlConnection &conn, const String &table)
@@ -126,7 +140,7 @@ really_get_tables(SqlConnection &conn, const String &type,
     SqlResultSet rs = cursor->exec(params);
     for (SqlResultSet::iterator i = rs.begin(); i != rs.end(); ++i)
     {
-        tables.push_back(str_to_upper((*i)[0].second.as_string()));
+        tables.push_back(str_to_upper((*i)[0].as_string()));
     }
     return tables;
 }
@@ -168,15 +182,15 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
     for (SqlResultSet::iterator i = rs.begin(); i != rs.end(); ++i)
     {
         ColumnInfo x;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("NAME") == j->first)
+            if (_T("NAME") == i->name(j))
             {
-                x.name = str_to_upper(j->second.as_string());
+                x.name = str_to_upper((*i)[j].as_string());
             }
-            else if (_T("TYPE") == j->first)
+            else if (_T("TYPE") == i->name(j))
             {
-                x.type = str_to_upper(j->second.as_string());
+                x.type = str_to_upper((*i)[j].as_string());
                 int open_par = str_find(x.type, _T('('));
                 if (-1 != open_par) {
                     // split type size into its own field
@@ -189,18 +203,18 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
                     catch (const std::exception &) {}
                 }
             }
-            else if (_T("NOTNULL") == j->first)
+            else if (_T("NOTNULL") == i->name(j))
             {
-                x.notnull = _T("0") != j->second.as_string();
+                x.notnull = _T("0") != (*i)[j].as_string();
             }
-            else if (_T("DFLT_VALUE") == j->first)
+            else if (_T("DFLT_VALUE") == i->name(j))
             {
-                if (!j->second.is_null())
-                    x.default_value = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    x.default_value = (*i)[j].as_string();
             }
-            else if (_T("PK") == j->first)
+            else if (_T("PK") == i->name(j))
             {
-                x.pk = _T("0") != j->second.as_string();
+                x.pk = _T("0") != (*i)[j].as_string();
             }
         }
         ci.push_back(x);
@@ -210,22 +224,22 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
     for (SqlResultSet::iterator i = rs2.begin(); i != rs2.end(); ++i)
     {
         String fk_column, fk_table, fk_table_key;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("TABLE") == j->first)
+            if (_T("TABLE") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_table = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table = (*i)[j].as_string();
             }
-            else if (_T("FROM") == j->first)
+            else if (_T("FROM") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_column = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_column = (*i)[j].as_string();
             }
-            else if (_T("TO") == j->first)
+            else if (_T("TO") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_table_key = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table_key = (*i)[j].as_string();
             }
         }
         for (ColumnsInfo::iterator k = ci.begin(); k != ci.end(); ++k)
@@ -33,11 +33,58 @@ MysqlDialect::select_last_inserted_id(const String &table_name)
     return _T("SELECT LAST_INSERT_ID() LID");
 }
 
+int
+MysqlDialect::inserted_id_model()
+{
+    // LAST_INSERT_ID() yields the id of the first row of a multi-row
+    // INSERT, the rest are consecutive unless innodb_autoinc_lock_mode=2
+    // (the MySQL 8 default), so it is used only with consecutive_ids=1
+    return (int)INSERTED_ID_FIRST_ROW;
+}
+
 const String
 MysqlDialect::sql_value(const Value &x)
 {
     return x.sql_str();
 }
+
+bool
+MysqlDialect::has_multirow_insert()
+{
+    return true;
+}
+
+bool
+MysqlDialect::has_row_value_in()
+{
+    return true;
+}
+
+const String
+MysqlDialect::sql_upsert(const String &table_name,
+        const Strings &columns, const Strings &key_columns,
+        const std::vector<Strings> &rows_params)
+{
+    Strings data_cols = non_key_columns(columns, key_columns);
+    // with no data columns the statement still must assign something
+    if (!data_cols.size())
+        data_cols.push_back(key_columns[0]);
+    String sql = sql_insert_values(table_name, columns, rows_params)
+        + _T(" ON DUPLICATE KEY UPDATE ");
+    for (size_t i = 0; i < data_cols.size(); ++i) {
+        if (i)
+            sql += _T(", ");
+        sql += data_cols[i] + _T(" = VALUES(") + data_cols[i] + _T(")");
+    }
+    return sql;
+}
+
+int
+MysqlDialect::max_bind_params()
+{
+    return 65535;
+}
+
 const String
 MysqlDialect::type2sql(int t) 
 {
@@ -132,7 +179,7 @@ MysqlDialect::get_tables(SqlConnection &conn)
     SqlResultSet rs = cursor->exec(params);
     for (SqlResultSet::iterator i = rs.begin(); i != rs.end(); ++i)
     {    
-        table.push_back(str_to_upper((*i)[0].second.as_string()));
+        table.push_back(str_to_upper((*i)[0].as_string()));
     }
     return table;
 
@@ -163,16 +210,16 @@ MysqlDialect::get_columns(SqlConnection &conn, const String &table)
     {//was not declared in this scope
        
         ColumnInfo x;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("FIELD") == j->first)
+            if (_T("FIELD") == i->name(j))
             {
-                x.name = str_to_upper(j->second.as_string());
+                x.name = str_to_upper((*i)[j].as_string());
                 cout << "Field \n";
             }
-            else if (_T("TYPE") == j->first)
+            else if (_T("TYPE") == i->name(j))
             {
-                x.type = str_to_upper(j->second.as_string());
+                x.type = str_to_upper((*i)[j].as_string());
                 int open_par = str_find(x.type, _T('('));
                 cout << "Type \n";
                 if (-1 != open_par) {
@@ -186,26 +233,26 @@ MysqlDialect::get_columns(SqlConnection &conn, const String &table)
                     catch (const std::exception &) {}
                 }
             }
-            else if (_T("NULL") == j->first)
+            else if (_T("NULL") == i->name(j))
             {
-                x.notnull = _T("NO") == j->second.as_string();
+                x.notnull = _T("NO") == (*i)[j].as_string();
                 cout << "Null \n";
             }
-            else if (_T("DEFAULT") == j->first)
+            else if (_T("DEFAULT") == i->name(j))
             {
-                if (!j->second.is_null())
-                    x.default_value = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    x.default_value = (*i)[j].as_string();
                     cout << "Default\n";
             }
-            else if (_T("KEY") == j->first)
+            else if (_T("KEY") == i->name(j))
             {
-                x.pk = _T("PRI") == j->second.as_string();
+                x.pk = _T("PRI") == (*i)[j].as_string();
                 cout << "Key\n";
             }
             /*It is unclear how to add structure Exstra
-            else if (_T("Exstra") == j->first) 
+            else if (_T("Exstra") == i->name(j)) 
             {
-                x.pk = _T("0") != j->second.as_string();
+                x.pk = _T("0") != (*i)[j].as_string();
             }*/
         }
        
@@ -221,30 +268,30 @@ MysqlDialect::get_columns(SqlConnection &conn, const String &table)
     for (SqlResultSet::iterator i = rs2.begin(); i != rs2.end(); ++i)
     {
         String fk_column, fk_table, fk_table_key;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
             cout << "\nkey\n";
-            if (_T("REFERENCED_TABLE_NAME") == j->first)
+            if (_T("REFERENCED_TABLE_NAME") == i->name(j))
             {
                 cout << "\ntable \n";
-                if (!j->second.is_null())       
-                    fk_table = j->second.as_string();
+                if (!(*i)[j].is_null())       
+                    fk_table = (*i)[j].as_string();
                      cout << "\n table2 \n";
             }
-              else if (_T("REFERENCED_COLUMN_NAME") == j->first)
+              else if (_T("REFERENCED_COLUMN_NAME") == i->name(j))
             { 
                 
                 cout << "\n name \n";
-                if (!j->second.is_null())
-                    fk_table_key = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table_key = (*i)[j].as_string();
                     cout << "\nname2 \n";
             
             }   
-            else if (_T("COLUMN_NAME"== j->first))
+            else if (_T("COLUMN_NAME"== i->name(j)))
             {
-                if (!j->second.is_null())
+                if (!(*i)[j].is_null())
                 cout << "\n non \n";
-                    fk_column = j->second.as_string();
+                    fk_column = (*i)[j].as_string();
                       cout << "\nnon2 \n";
             }        
            
@@ -295,7 +342,7 @@ really_get_tables(SqlConnection &conn, const String &type,
     SqlResultSet rs = cursor->exec(params);
     for (SqlResultSet::iterator i = rs.begin(); i != rs.end(); ++i)
     {
-        tables.push_back(str_to_upper((*i)[0].second.as_string()));
+        tables.push_back(str_to_upper((*i)[0].as_string()));
     }
     return tables;
 }sql коннект к базе с++
@@ -338,15 +385,15 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
     {was not declared in this scope
 
         ColumnInfo x;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("NAME") == j->first)
+            if (_T("NAME") == i->name(j))
             {
-                x.name = str_to_upper(j->second.as_string());
+                x.name = str_to_upper((*i)[j].as_string());
             }
-            else if (_T("TYPE") == j->first)
+            else if (_T("TYPE") == i->name(j))
             {
-                x.type = str_to_upper(j->second.as_string());
+                x.type = str_to_upper((*i)[j].as_string());
                 int open_par = str_find(x.type, _T('('));
                 if (-1 != open_par) {
                     // split type size into its own field
@@ -359,18 +406,18 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
                     catch (const std::exception &) {}
                 }
             }
-            else if (_T("NOTNULL") == j->first)
+            else if (_T("NOTNULL") == i->name(j))
             {
-                x.notnull = _T("0") != j->second.as_string();
+                x.notnull = _T("0") != (*i)[j].as_string();
             }
-            else if (_T("DFLT_VALUE") == j->first)
+            else if (_T("DFLT_VALUE") == i->name(j))
             {
-                if (!j->second.is_null())
-                    x.default_value = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    x.default_value = (*i)[j].as_string();
             }
-            else if (_T("PK") == j->first)
+            else if (_T("PK") == i->name(j))
             {
-                x.pk = _T("0") != j->second.as_string();
+                x.pk = _T("0") != (*i)[j].as_string();
             }
         }
         ci.push_back(x);
@@ -380,22 +427,22 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
     for (SqlResultSet::iterator i = rs2.begin(); i != rs2.end(); ++i)
     {
         String fk_column, fk_table, fk_table_key;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("TABLE") == j->first)
+            if (_T("TABLE") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_table = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table = (*i)[j].as_string();
             }
-            else if (_T("FROM") == j->first)
+            else if (_T("FROM") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_column = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_column = (*i)[j].as_string();
             }
-            else if (_T("TO") == j->first)
+            else if (_T("TO") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_table_key = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table_key = (*i)[j].as_string();
             }
         }
         for (ColumnsInfo::iterator k = ci.begin(); k != ci.end(); ++k)
@@ -72,6 +72,56 @@ OracleDialect::pager_model()
     return (int)PAGER_ORACLE;
 }
 
+bool
+OracleDialect::has_row_value_in()
+{
+    return true;
+}
+
+const String
+OracleDialect::sql_upsert(const String &table_name,
+        const Strings &columns, const Strings &key_columns,
+        const std::vector<Strings> &rows_params)
+{
+    String sql = _T("MERGE INTO ") + table_name + _T(" USING (");
+    for (size_t i = 0; i < rows_params.size(); ++i) {
+        if (i)
+            sql += _T(" UNION ALL ");
+        sql += _T("SELECT ");
+        for (size_t j = 0; j < columns.size(); ++j) {
+            if (j)
+                sql += _T(", ");
+            sql += rows_params[i][j] + _T(" ") + columns[j];
+        }
+        sql += _T(" FROM DUAL");
+    }
+    sql += _T(") S ON (");
+    for (size_t i = 0; i < key_columns.size(); ++i) {
+        if (i)
+            sql += _T(" AND ");
+        sql += table_name + _T(".") + key_columns[i]
+            + _T(" = S.") + key_columns[i];
+    }
+    sql += _T(")");
+    Strings data_cols = non_key_columns(columns, key_columns);
+    if (data_cols.size()) {
+        sql += _T(" WHEN MATCHED THEN UPDATE SET ");
+        for (size_t i = 0; i < data_cols.size(); ++i) {
+            if (i)
+                sql += _T(", ");
+            sql += table_name + _T(".") + data_cols[i]
+                + _T(" = S.") + data_cols[i];
+        }
+    }
+    Strings src_cols;
+    for (size_t i = 0; i < columns.size(); ++i)
+        src_cols.push_back(_T("S.") + columns[i]);
+    sql += _T(" WHEN NOT MATCHED THEN INSERT (")
+        + ExpressionList(columns).get_sql() + _T(") VALUES (")
+        + ExpressionList(src_cols).get_sql() + _T(")");
+    return sql;
+}
+
 // schema introspection
 
 bool 
@@ -128,7 +178,7 @@ really_get_tables(SqlConnection &conn, const String &type,
     SqlResultSet rs = cursor->exec(params);
     for (SqlResultSet::iterator i = rs.begin(); i != rs.end(); ++i)
     {
-        tables.push_back(str_to_upper((*i)[0].second.as_string()));
+        tables.push_back(str_to_upper((*i)[0].as_string()));
     }
     return tables;
 }
@@ -170,15 +220,15 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
     for (SqlResultSet::iterator i = rs.begin(); i != rs.end(); ++i)
     {
         ColumnInfo x;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("NAME") == j->first)
+            if (_T("NAME") == i->name(j))
             {
-                x.name = str_to_upper(j->second.as_string());
+                x.name = str_to_upper((*i)[j].as_string());
             }
-            else if (_T("TYPE") == j->first)
+            else if (_T("TYPE") == i->name(j))
             {
-                x.type = str_to_upper(j->second.as_string());
+                x.type = str_to_upper((*i)[j].as_string());
                 int open_par = str_find(x.type, _T('('));
                 if (-1 != open_par) {
                     // split type size into its own field
@@ -191,18 +241,18 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
                     catch (const std::exception &) {}
                 }
             }
-            else if (_T("NOTNULL") == j->first)
+            else if (_T("NOTNULL") == i->name(j))
             {
-                x.notnull = _T("0") != j->second.as_string();
+                x.notnull = _T("0") != (*i)[j].as_string();
             }
-            else if (_T("DFLT_VALUE") == j->first)
+            else if (_T("DFLT_VALUE") == i->name(j))
             {
-                if (!j->second.is_null())
-                    x.default_value = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    x.default_value = (*i)[j].as_string();
             }
-            else if (_T("PK") == j->first)
+            else if (_T("PK") == i->name(j))
             {
-                x.pk = _T("0") != j->second.as_string();
+                x.pk = _T("0") != (*i)[j].as_string();
             }
         }
         ci.push_back(x);
@@ -212,22 +262,22 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
     for (SqlResultSet::iterator i = rs2.begin(); i != rs2.end(); ++i)
     {
         String fk_column, fk_table, fk_table_key;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("TABLE") == j->first)
+            if (_T("TABLE") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_table = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table = (*i)[j].as_string();
             }
-            else if (_T("FROM") == j->first)
+            else if (_T("FROM") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_column = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_column = (*i)[j].as_string();
             }
-            else if (_T("TO") == j->first)
+            else if (_T("TO") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_table_key = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table_key = (*i)[j].as_string();
             }
         }
         for (ColumnsInfo::iterator k = ci.begin(); k != ci.end(); ++k)
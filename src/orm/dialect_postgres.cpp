@@ -52,6 +52,12 @@ PostgresDialect::select_last_inserted_id(const String &table_name)
         + table_name + _T("'");
 }
 
+int
+PostgresDialect::inserted_id_model()
+{
+    return (int)INSERTED_ID_RETURNING;
+}
+
 
 const String 
 PostgresDialect::select_curr_value(const String &seq_name)
@@ -86,6 +92,34 @@ PostgresDialect::type2sql(int t)
     throw SqlDialectError(_T("Bad type"));
 }
 
+bool
+PostgresDialect::has_multirow_insert()
+{
+    return true;
+}
+
+bool
+PostgresDialect::has_row_value_in()
+{
+    return true;
+}
+
+const String
+PostgresDialect::sql_upsert(const String &table_name,
+        const Strings &columns, const Strings &key_columns,
+        const std::vector<Strings> &rows_params)
+{
+    // requires PostgreSQL 9.5 or later
+    return sql_on_conflict_update(table_name, columns, key_columns,
+            rows_params);
+}
+
+int
+PostgresDialect::max_bind_params()
+{
+    return 32767;
+}
+
 const String
 PostgresDialect::create_sequence(const String &seq_name) {
     return _T("CREATE SEQUENCE ") + seq_name;
@@ -152,7 +186,7 @@ really_get_tables(SqlConnection &conn, const String &type,
     SqlResultSet rs = cursor->exec(params);
     for (SqlResultSet::iterator i = rs.begin(); i != rs.end(); ++i)
     {
-        tables.push_back(str_to_upper((*i)[0].second.as_string()));
+        tables.push_back(str_to_upper((*i)[0].as_string()));
     }
     return tables;
 }
@@ -194,15 +228,15 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
     for (SqlResultSet::iterator i = rs.begin(); i != rs.end(); ++i)
     {
         ColumnInfo x;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("NAME") == j->first)
+            if (_T("NAME") == i->name(j))
             {
-                x.name = str_to_upper(j->second.as_string());
+                x.name = str_to_upper((*i)[j].as_string());
             }
-            else if (_T("TYPE") == j->first)
+            else if (_T("TYPE") == i->name(j))
             {
-                x.type = str_to_upper(j->second.as_string());
+                x.type = str_to_upper((*i)[j].as_string());
                 int open_par = str_find(x.type, _T('('));
                 if (-1 != open_par) {
                     // split type size into its own field
@@ -215,18 +249,18 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
                     catch (const std::exception &) {}
                 }
             }
-            else if (_T("NOTNULL") == j->first)
+            else if (_T("NOTNULL") == i->name(j))
             {
-                x.notnull = _T("0") != j->second.as_string();
+                x.notnull = _T("0") != (*i)[j].as_string();
             }
-            else if (_T("DFLT_VALUE") == j->first)
+            else if (_T("DFLT_VALUE") == i->name(j))
             {
-                if (!j->second.is_null())
-                    x.default_value = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    x.default_value = (*i)[j].as_string();
             }
-            else if (_T("PK") == j->first)
+            else if (_T("PK") == i->name(j))
             {
-                x.pk = _T("0") != j->second.as_string();
+                x.pk = _T("0") != (*i)[j].as_string();
             }
         }
         ci.push_back(x);
@@ -236,22 +270,22 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
     for (SqlResultSet::iterator i = rs2.begin(); i != rs2.end(); ++i)
     {
         String fk_column, fk_table, fk_table_key;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("TABLE") == j->first)
+            if (_T("TABLE") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_table = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table = (*i)[j].as_string();
             }
-            else if (_T("FROM") == j->first)
+            else if (_T("FROM") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_column = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_column = (*i)[j].as_string();
             }
-            else if (_T("TO") == j->first)
+            else if (_T("TO") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_table_key = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table_key = (*i)[j].as_string();
             }
         }
         for (ColumnsInfo::iterator k = ci.begin(); k != ci.end(); ++k)
@@ -39,6 +39,12 @@ SQLite3Dialect::select_last_inserted_id(const String &table_name)
         + table_name + _T("'");
 }
 
+int
+SQLite3Dialect::inserted_id_model()
+{
+    return (int)INSERTED_ID_LAST_ROW;
+}
+
 const String
 SQLite3Dialect::sql_value(const Value &x)
 {
@@ -71,6 +77,28 @@ SQLite3Dialect::has_for_update()
     return false;
 }
 
+bool
+SQLite3Dialect::has_multirow_insert()
+{
+    return true;
+}
+
+const String
+SQLite3Dialect::sql_upsert(const String &table_name,
+        const Strings &columns, const Strings &key_columns,
+        const std::vector<Strings> &rows_params)
+{
+    // requires SQLite 3.24 or later
+    return sql_on_conflict_update(table_name, columns, key_columns,
+            rows_params);
+}
+
+int
+SQLite3Dialect::max_bind_params()
+{
+    return 999;
+}
+
 const String
 SQLite3Dialect::create_sequence(const String &seq_name)
 {
@@ -120,7 +148,7 @@ really_get_tables(SqlConnection &conn, const String &type,
     SqlResultSet rs = cursor->exec(params);
     for (SqlResultSet::iterator i = rs.begin(); i != rs.end(); ++i)
     {
-        tables.push_back(str_to_upper((*i)[0].second.as_string()));
+        tables.push_back(str_to_upper((*i)[0].as_string()));
     }
     return tables;
 }
@@ -162,15 +190,15 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
     for (SqlResultSet::iterator i = rs.begin(); i != rs.end(); ++i)
     {
         ColumnInfo x;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("NAME") == j->first)
+            if (_T("NAME") == i->name(j))
             {
-                x.name = str_to_upper(j->second.as_string());
+                x.name = str_to_upper((*i)[j].as_string());
             }
-            else if (_T("TYPE") == j->first)
+            else if (_T("TYPE") == i->name(j))
             {
-                x.type = str_to_upper(j->second.as_string());
+                x.type = str_to_upper((*i)[j].as_string());
                 int open_par = str_find(x.type, _T('('));
                 if (-1 != open_par) {
                     // split type size into its own field
@@ -183,18 +211,18 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
                     catch (const std::exception &) {}
                 }
             }
-            else if (_T("NOTNULL") == j->first)
+            else if (_T("NOTNULL") == i->name(j))
             {
-                x.notnull = _T("0") != j->second.as_string();
+                x.notnull = _T("0") != (*i)[j].as_string();
             }
-            else if (_T("DFLT_VALUE") == j->first)
+            else if (_T("DFLT_VALUE") == i->name(j))
             {
-                if (!j->second.is_null())
-                    x.default_value = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    x.default_value = (*i)[j].as_string();
             }
-            else if (_T("PK") == j->first)
+            else if (_T("PK") == i->name(j))
             {
-                x.pk = _T("0") != j->second.as_string();
+                x.pk = _T("0") != (*i)[j].as_string();
             }
         }
         ci.push_back(x);
@@ -204,22 +232,22 @@ SQLite3Dialect::get_columns(SqlConnection &conn, const String &table)
     for (SqlResultSet::iterator i = rs2.begin(); i != rs2.end(); ++i)
     {
         String fk_column, fk_table, fk_table_key;
-        for (Row::const_iterator j = i->begin(); j != i->end(); ++j)
+        for (size_t j = 0; j < i->size(); ++j)
         {
-            if (_T("TABLE") == j->first)
+            if (_T("TABLE") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_table = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table = (*i)[j].as_string();
             }
-            else if (_T("FROM") == j->first)
+            else if (_T("FROM") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_column = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_column = (*i)[j].as_string();
             }
-            else if (_T("TO") == j->first)
+            else if (_T("TO") == i->name(j))
             {
-                if (!j->second.is_null())
-                    fk_table_key = j->second.as_string();
+                if (!(*i)[j].is_null())
+                    fk_table_key = (*i)[j].as_string();
             }
         }
         for (ColumnsInfo::iterator k = ci.begin(); k != ci.end(); ++k)
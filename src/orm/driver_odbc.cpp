@@ -9,27 +9,68 @@
 #endif // _MSC_VER
 
 using namespace std;
-using Yb::StrUtils::str_to_upper;
 
 namespace Yb {
 
-OdbcCursorBackend::OdbcCursorBackend(tiodbc::connection *conn)
+static void
+fill_timestamp(TIMESTAMP_STRUCT &ts, const DateTime &t)
+{
+    ts.year = dt_year(t);
+    ts.month = dt_month(t);
+    ts.day = dt_day(t);
+    ts.hour = (SQLUSMALLINT)dt_hour(t);
+    ts.minute = (SQLUSMALLINT)dt_minute(t);
+    ts.second = (SQLUSMALLINT)dt_second(t);
+    ts.fraction = dt_millisec(t) * 1000000;
+}
+
+OdbcCursorBackend::OdbcCursorBackend(tiodbc::connection *conn,
+        int block_rows, int lob_size)
     : conn_(conn)
+    , rows_(new tiodbc::row_array(block_rows, lob_size))
+    , bound_(false)
+    , row_pos_(0)
+    , row_count_(0)
 {}
 
+void
+OdbcCursorBackend::bind_columns()
+{
+    bound_ = false;
+    row_pos_ = row_count_ = 0;
+    if (stmt_->count_columns() > 0)
+        bound_ = stmt_->bind_array(*rows_);
+}
+
+bool
+OdbcCursorBackend::next_row()
+{
+    if (!bound_)
+        return stmt_->fetch_next();
+    if (++row_pos_ < row_count_)
+        return true;
+    row_pos_ = 0;
+    row_count_ = stmt_->fetch_array(*rows_);
+    return row_count_ > 0;
+}
+
 void
 OdbcCursorBackend::exec_direct(const String &sql)
 {
     stmt_.reset(NULL);
+    header_ = RowHeaderPtr();
     stmt_.reset(new tiodbc::statement());
     if (!stmt_->execute_direct(*conn_, sql))
         throw DBError(stmt_->last_error_ex());
+    bind_columns();
 }
 
 void
 OdbcCursorBackend::prepare(const String &sql)
 {
     stmt_.reset(NULL);
+    header_ = RowHeaderPtr();
+    bound_ = false;
     stmt_.reset(new tiodbc::statement());
     if (!stmt_->prepare(*conn_, sql))
         throw DBError(stmt_->last_error_ex());
@@ -45,15 +86,8 @@ OdbcCursorBackend::exec(const Values &params)
                 break;
             }
             case Value::DATETIME: {
-                const DateTime &t = params[i].read_as<DateTime>();
                 TIMESTAMP_STRUCT ts;
-                ts.year = dt_year(t);
-                ts.month = dt_month(t);
-                ts.day = dt_day(t);
-                ts.hour = (SQLUSMALLINT)dt_hour(t);
-                ts.minute = (SQLUSMALLINT)dt_minute(t);
-                ts.second = (SQLUSMALLINT)dt_second(t);
-                ts.fraction = dt_millisec(t) * 1000000;
+                fill_timestamp(ts, params[i].read_as<DateTime>());
                 stmt_->param(i + 1).set_as_date_time(ts, false);
                 break;
             }
@@ -85,74 +119,174 @@ OdbcCursorBackend::exec(const Values &params)
     }
     if (!stmt_->execute())
         throw DBError(stmt_->last_error_ex());
+    bind_columns();
 }
 
-RowPtr
-OdbcCursorBackend::fetch_row()
+void
+OdbcCursorBackend::exec_many(const std::vector<Values> &params_list)
 {
-    if (!stmt_->fetch_next())
-        return RowPtr();
-    int col_count = stmt_->count_columns();
-    RowPtr row(new Row);
-    row->reserve(col_count);
-    for (int i = 0; i < col_count; ++i) {
-        tiodbc::field_impl f = stmt_->field(i + 1);
-        row->push_back(make_pair(str_to_upper(f.get_name()), Value()));
-        Value &v = (*row)[row->size() - 1].second;
-        switch (f.get_type()) {
-            case SQL_DATE:
-            case SQL_TIMESTAMP:
-            case SQL_TYPE_DATE:
-            case SQL_TYPE_TIME:
-            case SQL_TYPE_TIMESTAMP: {
-                TIMESTAMP_STRUCT ts = f.as_date_time();
-                if (!f.is_null())
-                    v = Value(dt_make(ts.year, ts.month, ts.day,
-                                       ts.hour, ts.minute, ts.second,
-                                       ts.fraction/1000000));
-                break;
-            }
-            case SQL_INTEGER:
-            case SQL_SMALLINT:
-            case SQL_TINYINT: {
-                int x = f.as_long();
-                if (!f.is_null())
-                    v = Value(x);
-                break;
-            }
-            case SQL_BIGINT: {
-                LongInt x = f.as_long_long();
-                if (!f.is_null())
-                    v = Value(x);
-                break;
-            }
-            case SQL_REAL:
-            case SQL_FLOAT:
-            case SQL_DOUBLE: {
-                double x = f.as_double();
-                if (!f.is_null())
-                    v = Value(x);
-                break;
+    if (params_list.size() < 2) {
+        SqlCursorBackend::exec_many(params_list);
+        return;
+    }
+    tiodbc::param_array arr((int)params_list.size());
+    for (size_t j = 0; j < params_list.size(); ++j) {
+        const Values &params = params_list[j];
+        for (size_t i = 0; i < params.size(); ++i) {
+            int n = (int)i + 1, row = (int)j;
+            bool ok = true;
+            switch (params[i].get_type()) {
+                case Value::INVALID: {
+                    arr.set_as_null(n, row);
+                    break;
+                }
+                case Value::DATETIME: {
+                    TIMESTAMP_STRUCT ts;
+                    fill_timestamp(ts, params[i].read_as<DateTime>());
+                    ok = arr.set_as_date_time(n, row, ts);
+                    break;
+                }
+                case Value::INTEGER: {
+                    ok = arr.set_as_long(n, row, params[i].read_as<int>());
+                    break;
+                }
+                case Value::LONGINT: {
+                    ok = arr.set_as_long_long(n, row,
+                            params[i].read_as<LongInt>());
+                    break;
+                }
+                case Value::FLOAT: {
+                    ok = arr.set_as_double(n, row,
+                            params[i].read_as<double>());
+                    break;
+                }
+                case Value::STRING: {
+                    ok = arr.set_as_string(n, row,
+                            params[i].read_as<String>());
+                    break;
+                }
+                default: {
+                    ok = arr.set_as_string(n, row, params[i].as_string());
+                }
             }
-            case SQL_DECIMAL:
-            case SQL_NUMERIC: {
-                String x = f.as_string();
-                if (!f.is_null())
-                    v = Value(Decimal(x));
-                break;
-            }
-            default: {
-                String x = f.as_string();
-                if (!f.is_null())
-                    v = Value(x);
+            if (!ok) {
+                // the same parameter has values of different types
+                SqlCursorBackend::exec_many(params_list);
+                return;
             }
         }
     }
+    if (!stmt_->execute_array(arr))
+        throw DBError(stmt_->last_error_ex());
+}
+
+// Field is either tiodbc::field_impl or tiodbc::bound_field
+template <class Field>
+static void
+read_value(Value &v, const Field &f)
+{
+    v = Value();
+    switch (f.get_type()) {
+        case SQL_DATE:
+        case SQL_TIMESTAMP:
+        case SQL_TYPE_DATE:
+        case SQL_TYPE_TIME:
+        case SQL_TYPE_TIMESTAMP: {
+            TIMESTAMP_STRUCT ts = f.as_date_time();
+            if (!f.is_null())
+                v = Value(dt_make(ts.year, ts.month, ts.day,
+                                   ts.hour, ts.minute, ts.second,
+                                   ts.fraction/1000000));
+            break;
+        }
+        case SQL_INTEGER:
+        case SQL_SMALLINT:
+        case SQL_TINYINT: {
+            int x = f.as_long();
+            if (!f.is_null())
+                v = Value(x);
+            break;
+        }
+        case SQL_BIGINT: {
+            LongInt x = f.as_long_long();
+            if (!f.is_null())
+                v = Value(x);
+            break;
+        }
+        case SQL_REAL:
+        case SQL_FLOAT:
+        case SQL_DOUBLE: {
+            double x = f.as_double();
+            if (!f.is_null())
+                v = Value(x);
+            break;
+        }
+        case SQL_DECIMAL:
+        case SQL_NUMERIC: {
+            String x = f.as_string();
+            if (!f.is_null())
+                v = Value(Decimal(x));
+            break;
+        }
+        default: {
+            String x = f.as_string();
+            if (!f.is_null())
+                v = Value(x);
+        }
+    }
+}
+
+void
+OdbcCursorBackend::read_row(Row &row)
+{
+    if (!shptr_get(header_)) {
+        int col_count = stmt_->count_columns();
+        RowHeaderPtr header(new RowHeader);
+        for (int i = 0; i < col_count; ++i)
+            header->add(stmt_->field(i + 1).get_name());
+        header_ = header;
+    }
+    row.reset(header_);
+    for (size_t i = 0; i < row.size(); ++i) {
+        // unbound columns, if any, are read with SQLGetData
+        if (bound_ && rows_->is_bound(i + 1))
+            read_value(row[i], rows_->field(i + 1, row_pos_));
+        else
+            read_value(row[i], stmt_->field(i + 1));
+    }
+}
+
+RowPtr
+OdbcCursorBackend::fetch_row()
+{
+    if (!next_row())
+        return RowPtr();
+    RowPtr row(new Row);
+    read_row(*row);
     return row;
 }
 
+size_t
+OdbcCursorBackend::fetch_block(RowBlock &block, size_t n)
+{
+    size_t count = 0;
+    for (; count < n && next_row(); ++count)
+        read_row(block.add_row());
+    return count;
+}
+
+void
+OdbcCursorBackend::reset()
+{
+    if (stmt_.get())
+        stmt_->free_results();
+    row_pos_ = row_count_ = 0;
+}
+
 OdbcConnectionBackend::OdbcConnectionBackend(OdbcDriver *drv)
     : drv_(drv)
+    , block_rows_(64)
+    , lob_size_(8000)
 {}
 
 void
@@ -165,6 +299,8 @@ OdbcConnectionBackend::open(SqlDialect *dialect, const SqlSource &source)
                 source.get_as<int>(String(_T("timeout")), 10),
                 bool(source.get_as<int>(String(_T("autocommit")), 0))))
         throw DBError(conn_->last_error_ex());
+    block_rows_ = source.get_as<int>(String(_T("row_block")), 64);
+    lob_size_ = source.get_as<int>(String(_T("lob_size")), 8000);
 }
 
 void
@@ -186,7 +322,8 @@ auto_ptr<SqlCursorBackend>
 OdbcConnectionBackend::new_cursor()
 {
     auto_ptr<SqlCursorBackend> p(
-            (SqlCursorBackend *)new OdbcCursorBackend(conn_.get()));
+            (SqlCursorBackend *)new OdbcCursorBackend(conn_.get(),
+                block_rows_, lob_size_));
     return p;
 }
 
@@ -13,9 +13,140 @@ using namespace Yb::StrUtils;
 
 namespace Yb {
 
-SOCICursorBackend::SOCICursorBackend(soci::session *conn)
+static int
+soci_value_type(soci::data_type type)
+{
+    switch (type) {
+        case soci::dt_double:
+            return Value::FLOAT;
+        case soci::dt_integer:
+            return Value::INTEGER;
+        case soci::dt_long_long:
+        case soci::dt_unsigned_long_long:
+            return Value::LONGINT;
+        case soci::dt_date:
+            return Value::DATETIME;
+        default:
+            return Value::STRING;
+    }
+}
+
+static void
+tm_from_date_time(std::tm &x, const DateTime &d)
+{
+    memset(&x, 0, sizeof(x));
+    x.tm_year = dt_year(d) - 1900;
+    x.tm_mon = dt_month(d) - 1;
+    x.tm_mday = dt_day(d);
+    x.tm_hour = dt_hour(d);
+    x.tm_min = dt_minute(d);
+    x.tm_sec = dt_second(d);
+}
+
+SOCIBulkColumn::SOCIBulkColumn(int type)
+{
+    switch (type) {
+        case Value::INTEGER:
+        case Value::LONGINT:
+        case Value::FLOAT:
+        case Value::DATETIME:
+            type_ = type;
+            break;
+        default:
+            type_ = Value::STRING;
+    }
+}
+
+void
+SOCIBulkColumn::resize(size_t n)
+{
+    switch (type_) {
+        case Value::INTEGER: ints_.resize(n); break;
+        case Value::LONGINT: longs_.resize(n); break;
+        case Value::FLOAT: doubles_.resize(n); break;
+        case Value::DATETIME: times_.resize(n); break;
+        default: strings_.resize(n);
+    }
+    flags_.resize(n, soci::i_null);
+}
+
+void
+SOCIBulkColumn::exchange_into(soci::statement &stmt)
+{
+    switch (type_) {
+        case Value::INTEGER:
+            stmt.exchange(soci::into(ints_, flags_)); break;
+        case Value::LONGINT:
+            stmt.exchange(soci::into(longs_, flags_)); break;
+        case Value::FLOAT:
+            stmt.exchange(soci::into(doubles_, flags_)); break;
+        case Value::DATETIME:
+            stmt.exchange(soci::into(times_, flags_)); break;
+        default:
+            stmt.exchange(soci::into(strings_, flags_));
+    }
+}
+
+void
+SOCIBulkColumn::exchange_use(soci::statement &stmt)
+{
+    switch (type_) {
+        case Value::INTEGER:
+            stmt.exchange(soci::use(ints_, flags_)); break;
+        case Value::LONGINT:
+            stmt.exchange(soci::use(longs_, flags_)); break;
+        case Value::FLOAT:
+            stmt.exchange(soci::use(doubles_, flags_)); break;
+        case Value::DATETIME:
+            stmt.exchange(soci::use(times_, flags_)); break;
+        default:
+            stmt.exchange(soci::use(strings_, flags_));
+    }
+}
+
+void
+SOCIBulkColumn::set(size_t i, const Value &v)
+{
+    if (v.is_null()) {
+        flags_[i] = soci::i_null;
+        return;
+    }
+    flags_[i] = soci::i_ok;
+    switch (type_) {
+        case Value::INTEGER: ints_[i] = v.as_integer(); break;
+        case Value::LONGINT: longs_[i] = v.as_longint(); break;
+        case Value::FLOAT: doubles_[i] = v.as_float(); break;
+        case Value::DATETIME:
+            tm_from_date_time(times_[i], v.as_date_time()); break;
+        default: strings_[i] = NARROW(v.as_string());
+    }
+}
+
+const Value
+SOCIBulkColumn::get(size_t i) const
+{
+    if (flags_[i] == soci::i_null)
+        return Value();
+    switch (type_) {
+        case Value::INTEGER: return Value(ints_[i]);
+        case Value::LONGINT: return Value((LongInt)longs_[i]);
+        case Value::FLOAT: return Value(doubles_[i]);
+        case Value::DATETIME: {
+            const std::tm &when = times_[i];
+            return Value(dt_make(when.tm_year + 1900, when.tm_mon + 1,
+                        when.tm_mday, when.tm_hour,
+                        when.tm_min, when.tm_sec));
+        }
+        default: return Value(WIDEN(strings_[i]));
+    }
+}
+
+SOCICursorBackend::SOCICursorBackend(soci::session *conn, int fetch_block)
     : conn_(conn), stmt_(NULL), is_select_(false)
     , bound_first_(false), executed_(false)
+    , fetch_block_(fetch_block > 1? fetch_block: 1)
+    , bulk_select_(false), bulk_done_(false), bulk_pos_(0)
+    , bulk_stmt_(NULL)
 {}
 
 SOCICursorBackend::~SOCICursorBackend()
@@ -35,6 +166,13 @@ SOCICursorBackend::close()
             executed_ = false;
             sql_.empty();
         }
+        bulk_select_ = false;
+        header_ = RowHeaderPtr();
+        bulk_cols_.clear();
+        delete bulk_stmt_;
+        bulk_stmt_ = NULL;
+        bulk_types_.clear();
+        bulk_params_.clear();
     }
     catch (const soci::soci_error &e) {
         throw DBError(WIDEN(e.what()));
@@ -72,9 +210,13 @@ SOCICursorBackend::prepare(const String &sql)
 void
 SOCICursorBackend::bind_params(const TypeCodes &types)
 {
-    param_types_ = types;
-    if (in_params_.size())
+    if (in_params_.size()) {
+        // the statement may be reused from the connection's cache
+        if (bound_first_ && param_types_ == types)
+            return;
         throw DBError(_T("bind_params: already bound!"));
+    }
+    param_types_ = types;
     in_params_.resize(types.size());
     in_flags_.resize(types.size());
     for (size_t i = 0; i < types.size(); ++i) {
@@ -83,43 +225,99 @@ SOCICursorBackend::bind_params(const TypeCodes &types)
             case Value::INTEGER: {
                 if (in_params_[i].size() < sizeof(int))
                     in_params_[i].resize(sizeof(int));
-                int &x = *(int *)&(in_params_[i][0]);
-                x = 0;
-                stmt_->exchange(soci::use(x, in_flags_[i]));
+                *(int *)&(in_params_[i][0]) = 0;
                 break;
             }
             case Value::LONGINT: {
                 if (in_params_[i].size() < sizeof(LongInt))
                     in_params_[i].resize(sizeof(LongInt));
-                LongInt &x = *(LongInt *)&(in_params_[i][0]);
-                x = 0;
-                stmt_->exchange(soci::use(x, in_flags_[i]));
+                *(LongInt *)&(in_params_[i][0]) = 0;
                 break;
             }
             case Value::FLOAT: {
                 if (in_params_[i].size() < sizeof(double))
                     in_params_[i].resize(sizeof(double));
-                double &x = *(double *)&(in_params_[i][0]);
-                x = 0;
-                stmt_->exchange(soci::use(x, in_flags_[i]));
+                *(double *)&(in_params_[i][0]) = 0;
                 break;
             }
             case Value::DATETIME: {
                 if (in_params_[i].size() < sizeof(std::tm))
                     in_params_[i].resize(sizeof(std::tm));
+                memset(&(in_params_[i][0]), 0, sizeof(std::tm));
+                break;
+            }
+        }
+    }
+    exchange_params(*stmt_);
+    if (is_select_)
+        stmt_->exchange(soci::into(row_));
+    stmt_->define_and_bind();
+}
+
+void
+SOCICursorBackend::exchange_params(soci::statement &stmt)
+{
+    for (size_t i = 0; i < param_types_.size(); ++i) {
+        switch (param_types_[i]) {
+            case Value::INTEGER: {
+                int &x = *(int *)&(in_params_[i][0]);
+                stmt.exchange(soci::use(x, in_flags_[i]));
+                break;
+            }
+            case Value::LONGINT: {
+                LongInt &x = *(LongInt *)&(in_params_[i][0]);
+                stmt.exchange(soci::use(x, in_flags_[i]));
+                break;
+            }
+            case Value::FLOAT: {
+                double &x = *(double *)&(in_params_[i][0]);
+                stmt.exchange(soci::use(x, in_flags_[i]));
+                break;
+            }
+            case Value::DATETIME: {
                 std::tm &x = *(std::tm *)&(in_params_[i][0]);
-                memset(&x, 0, sizeof(x));
-                stmt_->exchange(soci::use(x, in_flags_[i]));
+                stmt.exchange(soci::use(x, in_flags_[i]));
                 break;
             }
             default: {
-                stmt_->exchange(soci::use(in_params_[i], in_flags_[i]));
+                stmt.exchange(soci::use(in_params_[i], in_flags_[i]));
             }
         }
     }
-    if (is_select_)
-        stmt_->exchange(soci::into(row_));
+}
+
+void
+SOCICursorBackend::describe_bulk_columns()
+{
+    // the statement has been executed without fetching,
+    // so only the column properties are known
+    RowHeaderPtr header(new RowHeader);
+    bulk_cols_.clear();
+    for (size_t i = 0; i < row_.size(); ++i) {
+        const soci::column_properties &props = row_.get_properties(i);
+        header->add(WIDEN(props.get_name()));
+        bulk_cols_.push_back(SOCIBulkColumn(
+                    soci_value_type(props.get_data_type())));
+    }
+    header_ = header;
+}
+
+void
+SOCICursorBackend::init_bulk_select()
+{
+    // re-create the statement with vectors in place of soci::row
+    delete stmt_;
+    stmt_ = NULL;
+    stmt_ = new soci::statement(*conn_);
+    stmt_->alloc();
+    stmt_->prepare(sql_);
+    exchange_params(*stmt_);
+    for (size_t i = 0; i < bulk_cols_.size(); ++i) {
+        bulk_cols_[i].resize(fetch_block_);
+        bulk_cols_[i].exchange_into(*stmt_);
+    }
     stmt_->define_and_bind();
+    bulk_select_ = true;
 }
 
 void
@@ -128,7 +326,7 @@ SOCICursorBackend::exec(const Values &params)
     try {
         if (!executed_ && in_params_.size())
             bound_first_ = true;
-        if (!bound_first_) {
+        if (!bound_first_ && !bulk_select_) {
             if (executed_) {
                 delete stmt_;
                 stmt_ = new soci::statement(*conn_);
@@ -168,14 +366,7 @@ SOCICursorBackend::exec(const Values &params)
                 }
                 case Value::DATETIME: {
                     std::tm &x = *(std::tm *)&(in_params_[i][0]);
-                    memset(&x, 0, sizeof(x));
-                    const DateTime &d = param.as_date_time();
-                    x.tm_year = dt_year(d) - 1900;
-                    x.tm_mon = dt_month(d) - 1;
-                    x.tm_mday = dt_day(d);
-                    x.tm_hour = dt_hour(d);
-                    x.tm_min = dt_minute(d);
-                    x.tm_sec = dt_second(d);
+                    tm_from_date_time(x, param.as_date_time());
                     break;
                 }
                 default: {
@@ -183,73 +374,196 @@ SOCICursorBackend::exec(const Values &params)
                 }
             }
         }
+        // the parameter buffers are bound for good only if their types
+        // are fixed, otherwise each execution re-binds them
+        if (is_select_ && !bulk_select_ && fetch_block_ > 1
+                && (bound_first_ || !params.size())) {
+            stmt_->execute(false);
+            describe_bulk_columns();
+            if (bulk_cols_.size())
+                init_bulk_select();
+        }
+        if (bulk_select_) {
+            bulk_done_ = false;
+            bulk_pos_ = 0;
+            for (size_t i = 0; i < bulk_cols_.size(); ++i)
+                bulk_cols_[i].resize(fetch_block_);
+        }
         stmt_->execute(!is_select_);
+        if (bulk_select_) {
+            // the vectors are shrunk to the number of rows fetched
+            for (size_t i = 0; i < bulk_cols_.size(); ++i)
+                bulk_cols_[i].resize(0);
+        }
     }
     catch (const soci::soci_error &e) {
         throw DBError(WIDEN(e.what()));
     }
 }
 
-RowPtr SOCICursorBackend::fetch_row()
+void
+SOCICursorBackend::exec_many(const std::vector<Values> &params_list)
 {
+    if (is_select_ || params_list.size() < 2) {
+        SqlCursorBackend::exec_many(params_list);
+        return;
+    }
     try {
+        size_t n_params = params_list[0].size();
+        TypeCodes types(n_params, Value::INVALID);
+        for (size_t i = 0; i < n_params; ++i) {
+            if (param_types_.size() == n_params)
+                types[i] = param_types_[i];
+            for (size_t j = 0; types[i] == Value::INVALID
+                    && j < params_list.size(); ++j)
+                types[i] = params_list[j][i].get_type();
+            types[i] = SOCIBulkColumn(types[i]).type_;
+        }
+        // the vectors stay bound to the statement, the values
+        // are written over them and the size is taken on execution
+        if (!bulk_stmt_ || bulk_types_ != types)
+            init_bulk_dml(types);
+        for (size_t i = 0; i < n_params; ++i) {
+            bulk_params_[i].resize(params_list.size());
+            for (size_t j = 0; j < params_list.size(); ++j)
+                bulk_params_[i].set(j, params_list[j][i]);
+        }
+        bulk_stmt_->execute(true);
+    }
+    catch (const soci::soci_error &e) {
+        throw DBError(WIDEN(e.what()));
+    }
+}
+
+void
+SOCICursorBackend::init_bulk_dml(const TypeCodes &types)
+{
+    delete bulk_stmt_;
+    bulk_stmt_ = NULL;
+    bulk_types_.clear();
+    bulk_params_.clear();
+    bulk_params_.reserve(types.size());
+    for (size_t i = 0; i < types.size(); ++i) {
+        bulk_params_.push_back(SOCIBulkColumn(types[i]));
+        // SOCI refuses to bind empty vectors
+        bulk_params_[i].resize(1);
+    }
+    bulk_stmt_ = new soci::statement(*conn_);
+    bulk_stmt_->alloc();
+    bulk_stmt_->prepare(sql_);
+    for (size_t i = 0; i < bulk_params_.size(); ++i)
+        bulk_params_[i].exchange_use(*bulk_stmt_);
+    bulk_stmt_->define_and_bind();
+    bulk_types_ = types;
+}
+
+bool
+SOCICursorBackend::next_bulk_row()
+{
+    if (bulk_pos_ >= bulk_cols_[0].size()) {
+        if (bulk_done_)
+            return false;
+        for (size_t i = 0; i < bulk_cols_.size(); ++i)
+            bulk_cols_[i].resize(fetch_block_);
         if (!stmt_->fetch()) {
-#ifdef YB_SOCI_DEBUG
-            cerr << "fetch(): false" << endl;
-#endif
-            return RowPtr();
+            bulk_done_ = true;
+            return false;
         }
-        RowPtr result(new Row);
-        int col_count = row_.size();
+        bulk_pos_ = 0;
+        if (!bulk_cols_[0].size())
+            return false;
+    }
+    return true;
+}
+
+void
+SOCICursorBackend::read_bulk_row(Row &row)
+{
+    row.reset(header_);
+    for (size_t i = 0; i < bulk_cols_.size(); ++i)
+        row[i] = bulk_cols_[i].get(bulk_pos_);
+    ++bulk_pos_;
+}
+
+void
+SOCICursorBackend::read_row(Row &row)
+{
+    int col_count = row_.size();
+    if (!shptr_get(header_)) {
+        RowHeaderPtr header(new RowHeader);
+        for (int i = 0; i < col_count; ++i)
+            header->add(WIDEN(row_.get_properties(i).get_name()));
+        header_ = header;
+    }
+    row.reset(header_);
 #ifdef YB_SOCI_DEBUG
-        cerr << "fetch(): col_count=" << col_count << endl;
+    cerr << "fetch(): col_count=" << col_count << endl;
 #endif
-        for (int i = 0; i < col_count; ++i) {
-            const soci::column_properties &props = row_.get_properties(i);
-            String name = str_to_upper(WIDEN(props.get_name()));
-            Value v;
-            if (row_.get_indicator(i) != soci::i_null) {
-                std::tm when;
-                unsigned long long x;
-                switch (props.get_data_type()) {
-                case soci::dt_string:
-                    v = Value(WIDEN(row_.get<string>(i)));
-                    break;
-                case soci::dt_double:
-                    v = Value(row_.get<double>(i));
-                    break;
-                case soci::dt_integer:
-                    v = Value(row_.get<int>(i));
-                    break;
+    for (int i = 0; i < col_count; ++i) {
+        const soci::column_properties &props = row_.get_properties(i);
+        Value &v = row[i];
+        v = Value();
+        if (row_.get_indicator(i) != soci::i_null) {
+            std::tm when;
+            unsigned long long x;
+            switch (props.get_data_type()) {
+            case soci::dt_string:
+                v = Value(WIDEN(row_.get<string>(i)));
+                break;
+            case soci::dt_double:
+                v = Value(row_.get<double>(i));
+                break;
+            case soci::dt_integer:
+                v = Value(row_.get<int>(i));
+                break;
 #if 0
-                case soci::dt_unsigned_long:
-                    x = row_.get<unsigned long>(i);
-                    v = Value((LongInt)x);
-                    break;
+            case soci::dt_unsigned_long:
+                x = row_.get<unsigned long>(i);
+                v = Value((LongInt)x);
+                break;
 #endif
-                case soci::dt_long_long:
-                    x = row_.get<long long>(i);
-                    v = Value((LongInt)x);
-                    break;
-                case soci::dt_unsigned_long_long:
-                    x = row_.get<unsigned long long>(i);
-                    v = Value((LongInt)x);
-                    break;
-                case soci::dt_date:
-                    when = row_.get<std::tm>(i);
-                    v = Value(dt_make(when.tm_year + 1900, when.tm_mon + 1,
-                                when.tm_mday, when.tm_hour,
-                                when.tm_min, when.tm_sec));
-                    break;
-                }
+            case soci::dt_long_long:
+                x = row_.get<long long>(i);
+                v = Value((LongInt)x);
+                break;
+            case soci::dt_unsigned_long_long:
+                x = row_.get<unsigned long long>(i);
+                v = Value((LongInt)x);
+                break;
+            case soci::dt_date:
+                when = row_.get<std::tm>(i);
+                v = Value(dt_make(when.tm_year + 1900, when.tm_mon + 1,
+                            when.tm_mday, when.tm_hour,
+                            when.tm_min, when.tm_sec));
+                break;
             }
+        }
+#ifdef YB_SOCI_DEBUG
+        cerr << "fetch(): col[" << i << "]: name=" << props.get_name()
+            << " type=" << props.get_data_type()
+            << " value=" << NARROW(v.sql_str()) << endl;
+#endif
+    }
+}
+
+RowPtr SOCICursorBackend::fetch_row()
+{
+    try {
+        if (bulk_select_) {
+            if (!next_bulk_row())
+                return RowPtr();
+            RowPtr result(new Row);
+            read_bulk_row(*result);
+            return result;
+        }
+        if (!stmt_->fetch()) {
 #ifdef YB_SOCI_DEBUG
-            cerr << "fetch(): col[" << i << "]: name=" << props.get_name()
-                << " type=" << props.get_data_type()
-                << " value=" << NARROW(v.sql_str()) << endl;
+            cerr << "fetch(): false" << endl;
 #endif
-            result->push_back(make_pair(name, v));
+            return RowPtr();
         }
+        RowPtr result(new Row);
+        read_row(*result);
         return result;
     }
     catch (const soci::soci_error &e) {
@@ -257,8 +571,43 @@ RowPtr SOCICursorBackend::fetch_row()
     }
 }
 
+size_t
+SOCICursorBackend::fetch_block(RowBlock &block, size_t n)
+{
+    try {
+        size_t count = 0;
+        if (bulk_select_) {
+            // the rows are copied out of the SOCI vectors
+            for (; count < n && next_bulk_row(); ++count)
+                read_bulk_row(block.add_row());
+        }
+        else {
+            for (; count < n && stmt_->fetch(); ++count)
+                read_row(block.add_row());
+        }
+        return count;
+    }
+    catch (const soci::soci_error &e) {
+        throw DBError(WIDEN(e.what()));
+    }
+}
+
+void
+SOCICursorBackend::reset()
+{
+    // SOCI has no call to close a cursor, its backends do that at
+    // the next execute(), so only the rows fetched ahead are dropped,
+    // the statement and its bound buffers are kept for the reuse
+    if (bulk_select_) {
+        bulk_done_ = true;
+        bulk_pos_ = 0;
+        for (size_t i = 0; i < bulk_cols_.size(); ++i)
+            bulk_cols_[i].resize(0);
+    }
+}
+
 SOCIConnectionBackend::SOCIConnectionBackend(SOCIDriver *drv)
-    : conn_(NULL), drv_(drv), own_handle_(false)
+    : conn_(NULL), drv_(drv), own_handle_(false), fetch_block_(1)
 {}
 
 SOCIConnectionBackend::~SOCIConnectionBackend()
@@ -287,6 +636,7 @@ SOCIConnectionBackend::open(SqlDialect *dialect, const SqlSource &source)
     close();
     ScopedLock lock(drv_->conn_mux_);
     own_handle_ = true;
+    fetch_block_ = source.get_as<int>(String(_T("fetch_block")), 1);
     try {
         String driver = source.driver();
         std::string soci_backend = "odbc";
@@ -320,7 +670,7 @@ auto_ptr<SqlCursorBackend>
 SOCIConnectionBackend::new_cursor()
 {
     auto_ptr<SqlCursorBackend> p(
-            (SqlCursorBackend *)new SOCICursorBackend(conn_));
+            (SqlCursorBackend *)new SOCICursorBackend(conn_, fetch_block_));
     return p;
 }
 
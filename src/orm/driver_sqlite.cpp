@@ -6,6 +6,7 @@
 
 using namespace std;
 using Yb::StrUtils::str_to_upper;
+using Yb::StrUtils::starts_with;
 
 namespace Yb {
 
@@ -27,6 +28,8 @@ SQLiteCursorBackend::close()
         last_code_ = 0;
         exec_count_ = 0;
     }
+    header_ = RowHeaderPtr();
+    bind_types_.clear();
 }
 
 void
@@ -50,64 +53,180 @@ SQLiteCursorBackend::prepare(const String &sql)
     }
 }
 
+void
+SQLiteCursorBackend::bind_params(const TypeCodes &types)
+{
+    bind_types_ = types;
+}
+
+void
+SQLiteCursorBackend::bind_value(int i, const Value &x)
+{
+    int type = x.get_type();
+    if (type != Value::INVALID && (size_t)i < bind_types_.size()
+            && bind_types_[i] != Value::INVALID)
+        type = bind_types_[i];
+    int rc;
+    switch (type) {
+    case Value::INVALID:
+        rc = sqlite3_bind_null(stmt_, i + 1);
+        break;
+    case Value::INTEGER:
+        rc = sqlite3_bind_int(stmt_, i + 1, x.as_integer());
+        break;
+    case Value::LONGINT:
+        rc = sqlite3_bind_int64(stmt_, i + 1, x.as_longint());
+        break;
+    case Value::FLOAT:
+        rc = sqlite3_bind_double(stmt_, i + 1, x.as_float());
+        break;
+    default:
+        {
+            // the caller's Value may be gone by sqlite3_step(), so
+            // the text is copied to a buffer owned by the cursor,
+            // one per parameter, reusing its storage between execs
+            if (text_params_.size() <= (size_t)i)
+                text_params_.resize(i + 1);
+            std::string &s = text_params_[i];
+            s = NARROW(x.as_string());
+            rc = sqlite3_bind_text(stmt_, i + 1,
+                    s.data(), s.size(), SQLITE_STATIC);
+        }
+    }
+    if (SQLITE_OK != rc)
+        throw DBError(WIDEN(sqlite3_errmsg(conn_)));
+}
+
 void
 SQLiteCursorBackend::exec(const Values &params)
 {
     if (exec_count_)
         sqlite3_reset(stmt_);
     ++exec_count_;
-    vector<string> str_params(params.size());
-    for (size_t i = 0; i < params.size(); ++i) {
-        if (params[i].get_type() == Value::INTEGER 
-                || params[i].get_type() == Value::LONGINT)
-        {
-            sqlite3_bind_int(stmt_, i + 1, params[i].as_integer());
-            if (SQLITE_OK != sqlite3_errcode(conn_)) {
-                const char *err = sqlite3_errmsg(conn_);
-                throw DBError(WIDEN(err));
-            }
-        } else if (params[i].is_null()) {
-            sqlite3_bind_null(stmt_, i + 1);
-            if (SQLITE_OK != sqlite3_errcode(conn_)) {
-                const char *err = sqlite3_errmsg(conn_);
-                throw DBError(WIDEN(err));
-            }
-        } else {
-            str_params[i] = NARROW(params[i].as_string());
-            sqlite3_bind_text(stmt_, i + 1,
-                    str_params[i].c_str(), str_params[i].size(), SQLITE_STATIC);
-            if (SQLITE_OK != sqlite3_errcode(conn_)) {
-                const char *err = sqlite3_errmsg(conn_);
-                throw DBError(WIDEN(err));
-            }
-        }
-    }
+    for (size_t i = 0; i < params.size(); ++i)
+        bind_value(i, params[i]);
     last_code_ = sqlite3_step(stmt_);
     if (last_code_ != SQLITE_DONE && last_code_ != SQLITE_ROW
             && last_code_ != SQLITE_OK)
         throw DBError(WIDEN(sqlite3_errmsg(conn_)));
 }
 
-RowPtr SQLiteCursorBackend::fetch_row()
+int
+SQLiteCursorBackend::decl_type_hint(const char *decl_type)
+{
+    if (!decl_type)
+        return Value::INVALID;
+    String t = str_to_upper(WIDEN(decl_type));
+    if (starts_with(t, _T("NUMERIC")) || starts_with(t, _T("DECIMAL")))
+        return Value::DECIMAL;
+    if (starts_with(t, _T("TIMESTAMP")) || starts_with(t, _T("DATE")))
+        return Value::DATETIME;
+    return Value::INVALID;
+}
+
+void
+SQLiteCursorBackend::describe_columns()
 {
-    if (SQLITE_DONE == last_code_ || SQLITE_OK == last_code_)
-        return RowPtr();
-    if (SQLITE_ROW != last_code_)
-        throw DBError(WIDEN(sqlite3_errmsg(conn_)));
     int col_count = sqlite3_column_count(stmt_);
-    RowPtr row(new Row(col_count));
+    RowHeaderPtr header(new RowHeader);
+    type_hints_.resize(col_count);
     for (int i = 0; i < col_count; ++i) {
-        String name = str_to_upper(WIDEN(sqlite3_column_name(stmt_, i)));
-        int type = sqlite3_column_type(stmt_, i);
-        (*row)[i].first = name;
-        if (SQLITE_NULL != type)
-            (*row)[i].second = Value(
-                    WIDEN((const char *)sqlite3_column_text(stmt_, i)));
+        header->add(WIDEN(sqlite3_column_name(stmt_, i)));
+        type_hints_[i] = decl_type_hint(sqlite3_column_decltype(stmt_, i));
+    }
+    header_ = header;
+}
+
+const Value
+SQLiteCursorBackend::fetch_column(int i, int hint)
+{
+    int type = sqlite3_column_type(stmt_, i);
+    switch (type) {
+    case SQLITE_NULL:
+        return Value();
+    case SQLITE_INTEGER:
+        if (hint == Value::DECIMAL)
+            return Value(Decimal(
+                        (decimal_numerator)sqlite3_column_int64(stmt_, i)));
+        return Value((LongInt)sqlite3_column_int64(stmt_, i));
+    case SQLITE_FLOAT:
+        if (hint != Value::DECIMAL)
+            return Value(sqlite3_column_double(stmt_, i));
+        // SQLite renders REAL with 15 significant digits,
+        // which is what a NUMERIC column was given on insert
+        break;
+    }
+    String s = WIDEN((const char *)sqlite3_column_text(stmt_, i));
+    try {
+        if (hint == Value::DECIMAL)
+            return Value(Decimal(s));
+        if (hint == Value::DATETIME && type == SQLITE_TEXT) {
+            DateTime x;
+            return Value(from_string(s, x));
+        }
     }
+    catch (const std::exception &) {
+        // leave it for Value::fix_type() to deal with
+    }
+    return Value(s);
+}
+
+bool
+SQLiteCursorBackend::has_row()
+{
+    if (SQLITE_DONE == last_code_ || SQLITE_OK == last_code_)
+        return false;
+    if (SQLITE_ROW != last_code_)
+        throw DBError(WIDEN(sqlite3_errmsg(conn_)));
+    return true;
+}
+
+void
+SQLiteCursorBackend::read_row(Row &row)
+{
+    if (!shptr_get(header_))
+        describe_columns();
+    row.reset(header_);
+    for (size_t i = 0; i < row.size(); ++i)
+        row[i] = fetch_column(i, type_hints_[i]);
     last_code_ = sqlite3_step(stmt_);
+}
+
+RowPtr SQLiteCursorBackend::fetch_row()
+{
+    if (!has_row())
+        return RowPtr();
+    RowPtr row(new Row);
+    read_row(*row);
     return row;
 }
 
+size_t
+SQLiteCursorBackend::fetch_block(RowBlock &block, size_t n)
+{
+    size_t count = 0;
+    for (; count < n && has_row(); ++count)
+        read_row(block.add_row());
+    return count;
+}
+
+bool
+SQLiteCursorBackend::last_insert_id(LongInt &id)
+{
+    id = sqlite3_last_insert_rowid(conn_);
+    return true;
+}
+
+void
+SQLiteCursorBackend::reset()
+{
+    if (stmt_ && exec_count_) {
+        sqlite3_reset(stmt_);
+        last_code_ = 0;
+        exec_count_ = 0;
+    }
+}
+
 SQLiteConnectionBackend::SQLiteConnectionBackend(SQLiteDriver *drv)
     : conn_(NULL), drv_(drv), own_handle_(false)
 {}
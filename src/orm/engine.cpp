@@ -15,6 +15,9 @@ namespace Yb {
 EngineBase::~EngineBase()
 {}
 
+IdAllocator *
+EngineBase::id_allocator() { return NULL; }
+
 EngineSource::~EngineSource()
 {}
 
@@ -45,8 +48,20 @@ EngineBase::select(const Expression &what,
             where_(where).group_by_(group_by).having_(having).
             order_by_(order_by).for_update(for_update));
     RowsPtr rows(new Rows);
-    copy_no_more_than_n(rs.begin(), rs.end(), max_rows,
-            back_inserter(*rows));
+    RowBlock block;
+    size_t block_rows = get_conn()->row_block();
+    while (max_rows < 0 || rows->size() < (size_t)max_rows) {
+        size_t n = block_rows;
+        if (max_rows >= 0 && rows->size() + n > (size_t)max_rows)
+            n = max_rows - rows->size();
+        size_t count = rs.fetch_block(block, n);
+        for (size_t i = 0; i < count; ++i) {
+            rows->push_back(Row());
+            rows->back().swap(block[i]);
+        }
+        if (count < n)
+            break;
+    }
     return rows;
 }
 
@@ -61,66 +76,136 @@ EngineBase::insert(const Table &table, const RowsData &rows,
     if (!rows.size())
         return ids;
     touch();
-    String sql;
-    TypeCodes type_codes;
-    ParamNums param_nums;
-    gen_sql_insert(sql, type_codes, param_nums, table,
-            !collect_new_ids, get_conn()->get_driver()->numbered_params());
-    Values params(type_codes.size());
+    bool numbered_params = get_conn()->get_driver()->numbered_params();
+    int id_model = get_dialect()->inserted_id_model();
+    // ids of a batch can't be derived from the first one unless the
+    // server is known to allocate them in one consecutive range
+    if (id_model == INSERTED_ID_FIRST_ROW && !get_conn()->consecutive_ids())
+        id_model = INSERTED_ID_PER_ROW;
+    String returning;
+    if (collect_new_ids && id_model == INSERTED_ID_RETURNING)
+        returning = _T(" RETURNING ") + table.get_surrogate_pk();
+    size_t row_params = insert_plan(table, !collect_new_ids,
+            numbered_params).type_codes_.size(), batch_rows = 1;
+    if (!collect_new_ids || id_model != INSERTED_ID_PER_ROW)
+        batch_rows = calc_insert_batch(get_conn(), row_params);
+    Values params;
+    // without ids to collect the statements go in arrays to exec_many()
+    vector<Values> sets;
+    size_t max_sets = get_conn()->param_array();
     auto_ptr<SqlCursor> cursor = get_conn()->new_cursor();
-    cursor->prepare(sql);
-    cursor->bind_params(type_codes);
+    const DmlPlan *plan = NULL;
+    DmlPlan tail_plan;
+    size_t prepared_rows = 0;
     auto_ptr<SqlCursor> cursor2;
-    if (collect_new_ids)
-        cursor2.reset(get_conn()->new_cursor().release());
     RowsData::const_iterator r = rows.begin(), rend = rows.end();
-    for (; r != rend; ++r) {
-        ParamNums::const_iterator f = param_nums.begin(),
-            fend = param_nums.end();
-        for (; f != fend; ++f)
-            params[f->second] = (**r)[table.idx_by_name(f->first)];
-        cursor->exec(params);
-        if (collect_new_ids) {
-            cursor2->prepare(get_dialect()->
-                    select_last_inserted_id(table.name()));
+    while (r != rend) {
+        size_t count = std::min(batch_rows, (size_t)(rend - r));
+        if (count != prepared_rows) {
+            if (sets.size()) {
+                cursor->exec_many(sets);
+                sets.clear();
+            }
+            // the last chunk may be shorter than the others, its plan
+            // is not kept in the Table to not have one per tail size
+            if (count == batch_rows)
+                plan = &insert_plan(table, !collect_new_ids,
+                        numbered_params, (int)count);
+            else {
+                build_insert_plan(tail_plan, table, !collect_new_ids,
+                        numbered_params, (int)count);
+                plan = &tail_plan;
+            }
+            cursor->prepare(plan->sql_ + returning);
+            cursor->bind_params(plan->type_codes_);
+            params.resize(plan->col_idx_.size());
+            prepared_rows = count;
+        }
+        Values *dst = &params;
+        if (!collect_new_ids) {
+            sets.push_back(Values(plan->col_idx_.size()));
+            dst = &sets.back();
+        }
+        const vector<int> &col_idx = plan->col_idx_;
+        for (size_t k = 0, s = 0; k < count; ++k, ++r)
+            for (size_t p = 0; p < row_params; ++p, ++s)
+                (*dst)[s] = (**r)[col_idx[s]];
+        if (!collect_new_ids) {
+            if (sets.size() >= max_sets) {
+                cursor->exec_many(sets);
+                sets.clear();
+            }
+            continue;
+        }
+        SqlResultSet rs = cursor->exec(params);
+        if (id_model == INSERTED_ID_RETURNING) {
+            SqlResultSet::iterator k = rs.begin(), kend = rs.end();
+            for (; k != kend; ++k)
+                ids.push_back((*k)[0].as_longint());
+            continue;
+        }
+        LongInt last_id = 0;
+        if (!cursor->last_insert_id(last_id)) {
+            if (!cursor2.get()) {
+                cursor2.reset(get_conn()->new_cursor().release());
+                cursor2->prepare(get_dialect()->
+                        select_last_inserted_id(table.name()));
+            }
             cursor2->exec(Values());
             RowsPtr id_rows = cursor2->fetch_rows();
-            ids.push_back((*id_rows)[0][0].second.as_longint());
+            last_id = (*id_rows)[0][0].as_longint();
         }
+        if (id_model == INSERTED_ID_LAST_ROW)
+            last_id -= (LongInt)count - 1;
+        for (size_t k = 0; k < count; ++k)
+            ids.push_back(last_id + (LongInt)k);
     }
+    if (sets.size())
+        cursor->exec_many(sets);
     return ids;
 }
 
 void
 EngineBase::update(const Table &table, const RowsData &rows)
+{
+    update(table, rows, ColumnMask());
+}
+
+void
+EngineBase::update(const Table &table, const RowsData &rows,
+        const ColumnMask &columns)
 {
     if (get_mode() == READ_ONLY)
         throw BadOperationInMode(
                 _T("Using UPDATE operation in read-only mode"));
     if (!rows.size())
         return;
+    const DmlPlan &plan = update_plan(table,
+            get_conn()->get_driver()->numbered_params(), columns);
+    if (str_empty(plan.sql_))
+        return;
     touch();
-    String sql;
-    TypeCodes type_codes;
-    ParamNums param_nums;
-    SqlGeneratorOptions options(NO_QUOTES,
-            get_dialect()->has_for_update(),
-            true,
-            get_conn()->get_driver()->numbered_params(),
-            (Yb::SqlPagerModel)get_dialect()->pager_model());
-    gen_sql_update(sql, type_codes, param_nums, table, options);
     auto_ptr<SqlCursor> cursor = get_conn()->new_cursor();
-    cursor->prepare(sql);
-    cursor->bind_params(type_codes);
-    Values params(type_codes.size());
+    cursor->prepare(plan.sql_);
+    cursor->bind_params(plan.type_codes_);
+    const vector<int> &col_idx = plan.col_idx_;
+    size_t n_params = col_idx.size();
+    size_t max_sets = get_conn()->param_array();
+    vector<Values> sets;
+    sets.reserve(std::min(max_sets, rows.size()));
     RowsData::const_iterator r = rows.begin(), rend = rows.end();
     for (; r != rend; ++r) {
-        ParamNums::const_iterator f = param_nums.begin(),
-            fend = param_nums.end();
-        for (; f != fend; ++f)
-            params[f->second] = (**r)[table.idx_by_name(f->first)];
-        cursor->exec(params);
+        sets.push_back(Values(n_params));
+        Values &params = sets.back();
+        for (size_t s = 0; s < n_params; ++s)
+            params[s] = (**r)[col_idx[s]];
+        if (sets.size() >= max_sets) {
+            cursor->exec_many(sets);
+            sets.clear();
+        }
     }
+    if (sets.size())
+        cursor->exec_many(sets);
 }
 
 void
@@ -132,24 +217,101 @@ EngineBase::delete_from(const Table &table, const Keys &keys)
     if (!keys.size())
         return;
     touch();
-    String sql;
-    TypeCodes type_codes;
-    SqlGeneratorOptions options(NO_QUOTES,
-            get_dialect()->has_for_update(),
-            true,
-            get_conn()->get_driver()->numbered_params(),
-            (Yb::SqlPagerModel)get_dialect()->pager_model());
-    gen_sql_delete(sql, type_codes, table, options);
+    size_t key_params = table.pk_fields().size();
+    size_t max_keys = calc_delete_batch(get_conn(), (int)key_params);
+    // fewer keys than a full batch are rounded up to a power of two,
+    // so that only a few plan sizes ever get cached in the Table
+    size_t batch_keys = max_keys;
+    if (keys.size() < max_keys) {
+        batch_keys = 1;
+        while (batch_keys < keys.size())
+            batch_keys *= 2;
+        batch_keys = std::min(batch_keys, max_keys);
+    }
+    const DmlPlan &plan = delete_plan(table,
+            get_conn()->get_driver()->numbered_params(), (int)batch_keys,
+            get_dialect()->has_row_value_in());
     auto_ptr<SqlCursor> cursor = get_conn()->new_cursor();
-    cursor->prepare(sql);
-    cursor->bind_params(type_codes);
-    Values params(type_codes.size());
+    cursor->prepare(plan.sql_);
+    cursor->bind_params(plan.type_codes_);
+    size_t n_params = plan.type_codes_.size();
+    size_t max_sets = get_conn()->param_array();
+    vector<Values> sets;
     Keys::const_iterator k = keys.begin(), kend = keys.end();
-    for (; k != kend; ++k) {
-        for (size_t i = 0; i < k->second.size(); ++i)
-            params[i] = k->second[i].second;
-        cursor->exec(params);
+    while (k != kend) {
+        sets.push_back(Values(n_params));
+        Values &params = sets.back();
+        // a short last chunk is padded by repeating its last key,
+        // so that the same statement is used for all the chunks
+        Keys::const_iterator last = k;
+        for (size_t n = 0, s = 0; n < batch_keys; ++n) {
+            if (k != kend)
+                last = k++;
+            for (size_t i = 0; i < key_params; ++i, ++s)
+                params[s] = last->second[i].second;
+        }
+        if (sets.size() >= max_sets) {
+            cursor->exec_many(sets);
+            sets.clear();
+        }
     }
+    if (sets.size())
+        cursor->exec_many(sets);
+}
+
+void
+EngineBase::upsert(const Table &table, const RowsData &rows)
+{
+    if (get_mode() == READ_ONLY)
+        throw BadOperationInMode(
+                _T("Using UPSERT operation in read-only mode"));
+    if (!rows.size())
+        return;
+    touch();
+    bool numbered_params = get_conn()->get_driver()->numbered_params();
+    size_t row_params = upsert_plan(table, get_dialect(),
+            numbered_params).type_codes_.size();
+    size_t batch_rows = calc_insert_batch(get_conn(), (int)row_params);
+    size_t max_sets = get_conn()->param_array();
+    vector<Values> sets;
+    auto_ptr<SqlCursor> cursor = get_conn()->new_cursor();
+    const DmlPlan *plan = NULL;
+    DmlPlan tail_plan;
+    size_t prepared_rows = 0;
+    RowsData::const_iterator r = rows.begin(), rend = rows.end();
+    while (r != rend) {
+        size_t count = std::min(batch_rows, (size_t)(rend - r));
+        if (count != prepared_rows) {
+            if (sets.size()) {
+                cursor->exec_many(sets);
+                sets.clear();
+            }
+            // a short last chunk gets an uncached plan, as in insert()
+            if (count == batch_rows)
+                plan = &upsert_plan(table, get_dialect(),
+                        numbered_params, (int)count);
+            else {
+                build_upsert_plan(tail_plan, table, get_dialect(),
+                        numbered_params, (int)count);
+                plan = &tail_plan;
+            }
+            cursor->prepare(plan->sql_);
+            cursor->bind_params(plan->type_codes_);
+            prepared_rows = count;
+        }
+        sets.push_back(Values(plan->col_idx_.size()));
+        Values &params = sets.back();
+        const vector<int> &col_idx = plan->col_idx_;
+        for (size_t k = 0, s = 0; k < count; ++k, ++r)
+            for (size_t p = 0; p < row_params; ++p, ++s)
+                params[s] = (**r)[col_idx[s]];
+        if (sets.size() >= max_sets) {
+            cursor->exec_many(sets);
+            sets.clear();
+        }
+    }
+    if (sets.size())
+        cursor->exec_many(sets);
 }
 
 void
@@ -181,7 +343,7 @@ EngineBase::select1(const Expression &what,
     RowPtr row = select_row(what, from, where);
     if (row->size() != 1)
         throw BadSQLOperation(_T("Unable to fetch exactly one column!"));
-    return row->begin()->second;
+    return (*row)[0];
 }
 
 LongInt
@@ -198,6 +360,15 @@ EngineBase::get_next_value(const String &seq_name)
             Expression(get_dialect()->dual_name()), Expression()).as_longint();
 }
 
+LongInt
+EngineBase::allocate_id(const String &seq_name)
+{
+    IdAllocator *allocator = id_allocator();
+    if (!allocator)
+        return get_next_value(seq_name);
+    return allocator->next_id(*this, seq_name);
+}
+
 void
 EngineBase::commit()
 {
@@ -286,7 +457,7 @@ EngineBase::drop_schema(const Schema &schema, bool ignore_errors)
 void
 EngineBase::gen_sql_insert(String &sql, TypeCodes &type_codes_out,
         ParamNums &param_nums_out, const Table &table,
-        bool include_pk, bool numbered_params)
+        bool include_pk, bool numbered_params, int batch_rows)
 {
     int count = 1, *pcount = NULL;
     if (numbered_params)
@@ -296,34 +467,94 @@ EngineBase::gen_sql_insert(String &sql, TypeCodes &type_codes_out,
     TypeCodes type_codes;
     type_codes.reserve(table.size());
     ParamNums param_nums;
-    Strings names, pholders;
+    Strings names;
     size_t i;
     for (i = 0; i < table.size(); ++i) {
         const Column &col = table[i];
         if ((!col.is_ro() || col.is_pk()) &&
                 (!col.is_pk() || include_pk))
         {
+            param_nums[col.name()] = type_codes.size();
+            type_codes.push_back(col.type());
+            names.push_back(col.name());
+        }
+    }
+    sql_query += ExpressionList(names).get_sql() + _T(") VALUES ");
+    for (int row = 0; row < batch_rows; ++row) {
+        Strings pholders;
+        for (i = 0; i < type_codes.size(); ++i) {
             if (pcount)
                 pholders.push_back(_T(":") + to_string(count));
             else
                 pholders.push_back(_T("?"));
             ++count;
+        }
+        if (row)
+            sql_query += _T(", ");
+        sql_query += _T("(") + ExpressionList(pholders).get_sql() + _T(")");
+    }
+    str_swap(sql, sql_query);
+    type_codes_out.swap(type_codes);
+    param_nums_out.swap(param_nums);
+}
+
+void
+EngineBase::gen_sql_upsert(String &sql, TypeCodes &type_codes_out,
+        ParamNums &param_nums_out, const Table &table, SqlDialect *dialect,
+        bool numbered_params, int batch_rows)
+{
+    if (!table.pk_fields().size())
+        throw BadSQLOperation(_T("cannot do UPSERT without primary key"));
+    TypeCodes type_codes;
+    type_codes.reserve(table.size());
+    ParamNums param_nums;
+    Strings names;
+    size_t i;
+    for (i = 0; i < table.size(); ++i) {
+        const Column &col = table[i];
+        if (!col.is_ro() || col.is_pk()) {
             param_nums[col.name()] = type_codes.size();
             type_codes.push_back(col.type());
             names.push_back(col.name());
         }
     }
-    sql_query += ExpressionList(names).get_sql() + _T(") VALUES (") + 
-        ExpressionList(pholders).get_sql() + _T(")");
+    int count = 1;
+    std::vector<Strings> rows_params(batch_rows);
+    for (int row = 0; row < batch_rows; ++row) {
+        for (i = 0; i < type_codes.size(); ++i, ++count) {
+            if (numbered_params)
+                rows_params[row].push_back(_T(":") + to_string(count));
+            else
+                rows_params[row].push_back(_T("?"));
+        }
+    }
+    String sql_query = dialect->sql_upsert(table.name(), names,
+            table.pk_fields(), rows_params);
+    if (str_empty(sql_query))
+        throw BadSQLOperation(_T("UPSERT is not supported by dialect ")
+                + dialect->get_name());
     str_swap(sql, sql_query);
     type_codes_out.swap(type_codes);
     param_nums_out.swap(param_nums);
 }
 
+int
+EngineBase::calc_insert_batch(SqlConnection *conn, int row_params)
+{
+    int batch_rows = conn->insert_batch();
+    if (batch_rows <= 1 || row_params <= 0
+            || !conn->get_dialect()->has_multirow_insert())
+        return 1;
+    int max_params = conn->max_bind_params();
+    if (max_params > 0 && batch_rows * row_params > max_params)
+        batch_rows = max_params / row_params;
+    return batch_rows > 1? batch_rows: 1;
+}
+
 void
 EngineBase::gen_sql_update(String &sql, TypeCodes &type_codes_out,
         ParamNums &param_nums_out, const Table &table,
-        const SqlGeneratorOptions &options)
+        const SqlGeneratorOptions &options, const ColumnMask *columns)
 {
     if (!table.pk_fields().size())
         throw BadSQLOperation(_T("cannot build update statement: no key in table"));
@@ -335,6 +566,8 @@ EngineBase::gen_sql_update(String &sql, TypeCodes &type_codes_out,
     size_t i;
     for (i = 0; i < table.size(); ++i) {
         const Column &col = table[i];
+        if (columns && (i >= columns->size() || !(*columns)[i]))
+            continue;
         if (!col.is_pk() && !col.is_ro()) {
             if (!type_codes.empty())
                 sql_query += _T(", ");
@@ -348,6 +581,13 @@ EngineBase::gen_sql_update(String &sql, TypeCodes &type_codes_out,
             type_codes.push_back(col.type());
         }
     }
+    if (columns && type_codes.empty()) {
+        // nothing to update
+        type_codes_out.clear();
+        param_nums_out.clear();
+        sql = String();
+        return;
+    }
     for (i = 0; i < table.pk_fields().size(); ++i) {
         const String &col_name = table.pk_fields()[i];
         param_nums[col_name] = type_codes.size();
@@ -364,7 +604,8 @@ EngineBase::gen_sql_update(String &sql, TypeCodes &type_codes_out,
 
 void
 EngineBase::gen_sql_delete(String &sql, TypeCodes &type_codes_out,
-        const Table &table, const SqlGeneratorOptions &options)
+        const Table &table, const SqlGeneratorOptions &options,
+        int batch_keys, bool row_value_in)
 {
     if (!table.pk_fields().size())
         throw BadSQLOperation(_T("cannot build update statement: no key in table"));
@@ -373,12 +614,180 @@ EngineBase::gen_sql_delete(String &sql, TypeCodes &type_codes_out,
     TypeCodes type_codes;
     Key sample_key;
     table.mk_sample_key(type_codes, sample_key);
-    sql_query += _T(" WHERE ")
-        + KeyFilter(sample_key).generate_sql(options, &ctx);
-    type_codes_out.swap(type_codes);
+    Expression where;
+    size_t key_params = sample_key.second.size();
+    if (batch_keys < 1)
+        batch_keys = 1;
+    if (batch_keys <= 1)
+        where = KeyFilter(sample_key);
+    else if (key_params == 1) {
+        // T.ID IN (?, ?, ...)
+        ExpressionList values;
+        for (int k = 0; k < batch_keys; ++k)
+            values << ConstExpr(sample_key.second[0].second);
+        where = ColumnExpr(table.name(), sample_key.second[0].first)
+            .in_(values);
+    }
+    else if (row_value_in) {
+        // (T.A, T.B) IN ((?, ?), (?, ?), ...)
+        ExpressionList cols, tuple, tuples;
+        for (size_t i = 0; i < key_params; ++i) {
+            cols << ColumnExpr(table.name(), sample_key.second[i].first);
+            tuple << ConstExpr(sample_key.second[i].second);
+        }
+        for (int k = 0; k < batch_keys; ++k)
+            tuples << tuple;
+        where = cols.in_(tuples);
+    }
+    else {
+        // (T.A = ? AND T.B = ?) OR (T.A = ? AND T.B = ?) OR ...
+        for (int k = 0; k < batch_keys; ++k)
+            where = where || KeyFilter(sample_key);
+    }
+    TypeCodes batch_types;
+    batch_types.reserve(type_codes.size() * batch_keys);
+    for (int k = 0; k < batch_keys; ++k)
+        batch_types.insert(batch_types.end(),
+                type_codes.begin(), type_codes.end());
+    sql_query += _T(" WHERE ") + where.generate_sql(options, &ctx);
+    type_codes_out.swap(batch_types);
     str_swap(sql, sql_query);
 }
 
+int
+EngineBase::calc_delete_batch(SqlConnection *conn, int key_params)
+{
+    int batch_keys = conn->delete_batch();
+    if (batch_keys <= 1 || key_params <= 0)
+        return 1;
+    int max_params = conn->max_bind_params();
+    if (max_params > 0 && batch_keys * key_params > max_params)
+        batch_keys = max_params / key_params;
+    return batch_keys > 1? batch_keys: 1;
+}
+
+static void
+fill_plan_columns(DmlPlan &plan, const Table &table,
+        const ParamNums &param_nums, int batch_rows = 1)
+{
+    size_t row_params = param_nums.size();
+    plan.col_idx_.resize(row_params * batch_rows);
+    ParamNums::const_iterator f = param_nums.begin(),
+        fend = param_nums.end();
+    for (; f != fend; ++f) {
+        int idx = (int)table.idx_by_name(f->first);
+        for (int k = 0; k < batch_rows; ++k)
+            plan.col_idx_[k * row_params + f->second] = idx;
+    }
+}
+
+static void
+fill_plan_types(DmlPlan &plan, const TypeCodes &type_codes, int batch_rows)
+{
+    plan.type_codes_.reserve(type_codes.size() * batch_rows);
+    for (int k = 0; k < batch_rows; ++k)
+        plan.type_codes_.insert(plan.type_codes_.end(),
+                type_codes.begin(), type_codes.end());
+}
+
+void
+EngineBase::build_insert_plan(DmlPlan &plan, const Table &table,
+        bool include_pk, bool numbered_params, int batch_rows)
+{
+    TypeCodes type_codes;
+    ParamNums param_nums;
+    gen_sql_insert(plan.sql_, type_codes, param_nums, table,
+            include_pk, numbered_params, batch_rows);
+    fill_plan_types(plan, type_codes, batch_rows);
+    fill_plan_columns(plan, table, param_nums, batch_rows);
+}
+
+const DmlPlan &
+EngineBase::insert_plan(const Table &table, bool include_pk,
+        bool numbered_params, int batch_rows)
+{
+    String plan_key = _T("INSERT:") + to_string((int)include_pk)
+        + _T(":") + to_string((int)numbered_params)
+        + _T(":") + to_string(batch_rows);
+    const DmlPlan *found = table.find_plan(plan_key);
+    if (found)
+        return *found;
+    DmlPlan plan;
+    build_insert_plan(plan, table, include_pk, numbered_params, batch_rows);
+    return table.add_plan(plan_key, plan);
+}
+
+const DmlPlan &
+EngineBase::update_plan(const Table &table, bool numbered_params,
+        const ColumnMask &columns)
+{
+    String plan_key = _T("UPDATE:") + to_string((int)numbered_params)
+        + _T(":");
+    for (size_t i = 0; i < columns.size(); ++i)
+        plan_key += columns[i]? _T("1"): _T("0");
+    const DmlPlan *found = table.find_plan(plan_key);
+    if (found)
+        return *found;
+    DmlPlan plan;
+    ParamNums param_nums;
+    SqlGeneratorOptions options(NO_QUOTES, true, true, numbered_params);
+    gen_sql_update(plan.sql_, plan.type_codes_, param_nums, table, options,
+            columns.empty()? NULL: &columns);
+    fill_plan_columns(plan, table, param_nums);
+    return table.add_plan(plan_key, plan);
+}
+
+const DmlPlan &
+EngineBase::delete_plan(const Table &table, bool numbered_params,
+        int batch_keys, bool row_value_in)
+{
+    if (batch_keys < 1)
+        batch_keys = 1;
+    String plan_key = _T("DELETE:") + to_string((int)numbered_params)
+        + _T(":") + to_string(batch_keys)
+        + _T(":") + to_string((int)row_value_in);
+    const DmlPlan *found = table.find_plan(plan_key);
+    if (found)
+        return *found;
+    DmlPlan plan;
+    SqlGeneratorOptions options(NO_QUOTES, true, true, numbered_params);
+    gen_sql_delete(plan.sql_, plan.type_codes_, table, options,
+            batch_keys, row_value_in);
+    const Strings &pk_fields = table.pk_fields();
+    for (int k = 0; k < batch_keys; ++k)
+        for (size_t i = 0; i < pk_fields.size(); ++i)
+            plan.col_idx_.push_back((int)table.idx_by_name(pk_fields[i]));
+    return table.add_plan(plan_key, plan);
+}
+
+void
+EngineBase::build_upsert_plan(DmlPlan &plan, const Table &table,
+        SqlDialect *dialect, bool numbered_params, int batch_rows)
+{
+    TypeCodes type_codes;
+    ParamNums param_nums;
+    gen_sql_upsert(plan.sql_, type_codes, param_nums, table, dialect,
+            numbered_params, batch_rows);
+    fill_plan_types(plan, type_codes, batch_rows);
+    fill_plan_columns(plan, table, param_nums, batch_rows);
+}
+
+const DmlPlan &
+EngineBase::upsert_plan(const Table &table, SqlDialect *dialect,
+        bool numbered_params, int batch_rows)
+{
+    // the statement syntax differs from one dialect to another
+    String plan_key = _T("UPSERT:") + dialect->get_name()
+        + _T(":") + to_string((int)numbered_params)
+        + _T(":") + to_string(batch_rows);
+    const DmlPlan *found = table.find_plan(plan_key);
+    if (found)
+        return *found;
+    DmlPlan plan;
+    build_upsert_plan(plan, table, dialect, numbered_params, batch_rows);
+    return table.add_plan(plan_key, plan);
+}
+
 EngineCloned::~EngineCloned()
 {
     if (pool_)
@@ -386,6 +795,7 @@ EngineCloned::~EngineCloned()
 }
 
 int EngineCloned::get_mode() { return mode_; }
+IdAllocator *EngineCloned::id_allocator() { return id_allocator_; }
 SqlConnection *EngineCloned::get_conn() { return conn_; }
 SqlDialect *EngineCloned::get_dialect() { return dialect_; }
 ILogger *EngineCloned::logger() { return logger_; }
@@ -467,6 +877,21 @@ Engine::~Engine()
 
 int Engine::get_mode() { return mode_; }
 
+IdAllocator *Engine::id_allocator()
+{
+    if (id_allocator_.get())
+        return id_allocator_.get();
+    if (pool_.get())
+        return pool_->id_allocator(source_id_);
+    id_allocator_.reset(new_id_allocator(conn_->get_source()).release());
+    return id_allocator_.get();
+}
+
+void Engine::set_id_allocator(auto_ptr<IdAllocator> id_allocator)
+{
+    id_allocator_.reset(id_allocator.release());
+}
+
 SqlConnection *Engine::get_conn()
 {
     if (conn_.get())
@@ -484,10 +909,12 @@ auto_ptr<EngineCloned> Engine::clone()
 {
     if (conn_.get())
         return auto_ptr<EngineCloned>(new EngineCloned(
-                    mode_, conn_.get(), dialect_, logger_.get()));
+                    mode_, conn_.get(), dialect_, logger_.get(),
+                    NULL, id_allocator()));
     SqlConnection *conn = get_from_pool();
     return auto_ptr<EngineCloned>(new EngineCloned(
-                mode_, conn, dialect_, logger_.get(), pool_.get()));
+                mode_, conn, dialect_, logger_.get(), pool_.get(),
+                id_allocator()));
 }
 
 void Engine::set_echo(bool echo)
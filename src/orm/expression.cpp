@@ -313,7 +313,7 @@ JoinExprBackend::generate_sql(
 {
     String sql = sql_parentheses_as_needed(
             expr1_.generate_sql(options, ctx));
-    sql += _T(" JOIN ");
+    sql += _T(" ") + kind_ + _T(" ");
     sql += sql_parentheses_as_needed(
             expr2_.generate_sql(options, ctx));
     sql += _T(" ON ");
@@ -323,8 +323,9 @@ JoinExprBackend::generate_sql(
 }
 
 JoinExpr::JoinExpr(const Expression &expr1,
-        const Expression &expr2, const Expression &cond)
-    : Expression(ExprBEPtr(new JoinExprBackend(expr1, expr2, cond)))
+        const Expression &expr2, const Expression &cond,
+        const String &kind)
+    : Expression(ExprBEPtr(new JoinExprBackend(expr1, expr2, cond, kind)))
 {}
 
 const Expression &
@@ -892,6 +893,26 @@ FilterBackendByPK::build_expr(const Key &key)
     return expr;
 }
 
+YBORM_DECL const Expression
+filter_keys(const Keys &keys)
+{
+    YB_ASSERT(!keys.empty());
+    if (keys.size() == 1)
+        return KeyFilter(keys[0]);
+    if (keys[0].second.size() != 1) {
+        Expression expr;
+        Keys::const_iterator i = keys.begin(), iend = keys.end();
+        for (; i != iend; ++i)
+            expr = expr || KeyFilter(*i);
+        return expr;
+    }
+    ExpressionList values;
+    Keys::const_iterator i = keys.begin(), iend = keys.end();
+    for (; i != iend; ++i)
+        values << ConstExpr(i->second[0].second);
+    return ColumnExpr(keys[0].first, keys[0].second[0].first).in_(values);
+}
+
 FilterBackendByPK::FilterBackendByPK(const Key &key)
     : expr_(build_expr(key))
     , key_(key)
@@ -0,0 +1,99 @@
+// -*- Mode: C++; c-basic-offset: 4; tab-width: 4; indent-tabs-mode: nil; -*-
+#define YBORM_SOURCE
+
+#include "util/string_utils.h"
+#include "orm/id_allocator.h"
+#include "orm/engine.h"
+
+using namespace std;
+using namespace Yb::StrUtils;
+
+namespace Yb {
+
+IdAllocator::~IdAllocator()
+{}
+
+LongInt
+SequenceIdAllocator::next_id(EngineBase &engine, const String &seq_name)
+{
+    return engine.get_next_value(seq_name);
+}
+
+HiLoIdAllocator::HiLoIdAllocator(int block_size, int block_mode)
+    : block_size_(block_size > 1? block_size: 1)
+    , block_mode_(block_mode)
+{}
+
+LongInt
+HiLoIdAllocator::reserve_block(EngineBase &engine, const String &seq_name)
+{
+    return engine.get_next_value(seq_name);
+}
+
+bool
+HiLoIdAllocator::take_id(Block &block, LongInt &id)
+{
+    if (block.next >= block.end) {
+        if (block.spare_next >= block.spare_end)
+            return false;
+        block.next = block.spare_next;
+        block.end = block.spare_end;
+        block.spare_next = block.spare_end = 0;
+    }
+    id = block.next++;
+    return true;
+}
+
+LongInt
+HiLoIdAllocator::next_id(EngineBase &engine, const String &seq_name)
+{
+    LongInt id;
+    {
+        ScopedLock lock(mux_);
+        if (take_id(blocks_[seq_name], id))
+            return id;
+    }
+    // the sequence is called without holding the lock, so the other
+    // threads are not kept waiting for the round trip
+    LongInt value = reserve_block(engine, seq_name);
+    LongInt next = block_mode_ == INCREMENT_BY? value: value * block_size_;
+    ScopedLock lock(mux_);
+    Block &block = blocks_[seq_name];
+    if (block.next < block.end || block.spare_next < block.spare_end) {
+        // another thread has got a block meanwhile, keep this one
+        // for later, unless there is a spare one already
+        if (block.spare_next >= block.spare_end) {
+            block.spare_next = next;
+            block.spare_end = next + block_size_;
+        }
+    }
+    else {
+        block.next = next;
+        block.end = next + block_size_;
+    }
+    take_id(block, id);
+    return id;
+}
+
+YBORM_DECL auto_ptr<IdAllocator>
+new_id_allocator(const SqlSource &source)
+{
+    int block_size = source.get_as<int>(String(_T("id_block")), 1);
+    if (block_size <= 1)
+        return auto_ptr<IdAllocator>(new SequenceIdAllocator());
+    String mode = str_to_lower(
+            source.get(String(_T("id_block_mode")), String(_T("hilo"))));
+    int block_mode;
+    if (mode == _T("hilo"))
+        block_mode = HiLoIdAllocator::HI_LO;
+    else if (mode == _T("increment_by"))
+        block_mode = HiLoIdAllocator::INCREMENT_BY;
+    else
+        throw ValueError(_T("Unknown id_block_mode: ") + mode);
+    return auto_ptr<IdAllocator>(
+            new HiLoIdAllocator(block_size, block_mode));
+}
+
+} // namespace Yb
+
+// vim:ts=4:sts=4:sw=4:et:
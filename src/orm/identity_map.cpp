@@ -0,0 +1,211 @@
+// -*- Mode: C++; c-basic-offset: 4; tab-width: 4; indent-tabs-mode: nil; -*-
+#define YBORM_SOURCE
+
+#include "util/string_utils.h"
+#include "orm/identity_map.h"
+#include "orm/data_object.h"
+
+using namespace std;
+
+namespace Yb {
+
+static inline size_t
+hash_mix(size_t h, size_t x)
+{
+    return h ^ (x + 0x9e3779b9 + (h << 6) + (h >> 2));
+}
+
+static inline size_t
+hash_longint(LongInt x)
+{
+    return hash_mix((size_t)x, (size_t)(x >> 32));
+}
+
+YBORM_DECL size_t
+hash_value(const Value &x)
+{
+    switch (x.get_type()) {
+    case Value::INVALID:
+        return 0;
+    case Value::INTEGER:
+        return hash_longint(x.read_as_integer());
+    case Value::LONGINT:
+        return hash_longint(x.read_as_longint());
+    case Value::STRING: {
+        // FNV-1a over the character codes
+        const String &s = x.read_as_string();
+        size_t h = 2166136261u, n = str_length(s);
+        for (size_t i = 0; i < n; ++i)
+            h = (h ^ (size_t)char_code(s[i])) * 16777619u;
+        return h;
+    }
+    case Value::DECIMAL:
+        // equal decimals of different precision share the integer part
+        return hash_longint(x.read_as_decimal().ipart());
+    case Value::DATETIME: {
+        const DateTime &d = x.read_as_datetime();
+        size_t h = hash_longint(dt_year(d) * 10000 +
+                dt_month(d) * 100 + dt_day(d));
+        return hash_mix(h, dt_hour(d) * 3600 + dt_minute(d) * 60 +
+                dt_second(d));
+    }
+    case Value::FLOAT:
+        return hash_longint((LongInt)x.read_as_float());
+    }
+    return 0;
+}
+
+ObjectKey::ObjectKey(const Table &table, const Value *row)
+    : table_(&table)
+    , values_(row)
+    , packed_(false)
+    , hash_(0)
+{
+    init_hash();
+}
+
+ObjectKey::ObjectKey(const Table &table, const Value *values, bool packed)
+    : table_(&table)
+    , values_(values)
+    , packed_(packed)
+    , hash_(0)
+{
+    init_hash();
+}
+
+void
+ObjectKey::init_hash()
+{
+    hash_ = hash_mix((size_t)table_, 0);
+    for (size_t i = 0; i < size(); ++i)
+        hash_ = hash_mix(hash_, hash_value(value(i)));
+}
+
+bool
+ObjectKey::assigned() const
+{
+    for (size_t i = 0; i < size(); ++i)
+        if (value(i).is_null())
+            return false;
+    return true;
+}
+
+bool
+ObjectKey::operator==(const ObjectKey &other) const
+{
+    if (table_ != other.table_ || hash_ != other.hash_)
+        return false;
+    for (size_t i = 0; i < size(); ++i)
+        if (value(i) != other.value(i))
+            return false;
+    return true;
+}
+
+static inline bool
+has_key(const DataObject *obj, const ObjectKey &key)
+{
+    if (&obj->table() != &key.table())
+        return false;
+    const Values &values = obj->raw_values();
+    const std::vector<size_t> &idx = key.table().pk_indexes();
+    for (size_t i = 0; i < idx.size(); ++i)
+        if (values[idx[i]] != key.value(i))
+            return false;
+    return true;
+}
+
+size_t
+IdentityMap::find_slot(const ObjectKey &key) const
+{
+    size_t mask = slots_.size() - 1, pos = key.hash() & mask;
+    while (slots_[pos].obj) {
+        if (slots_[pos].hash == key.hash() && has_key(slots_[pos].obj, key))
+            break;
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+void
+IdentityMap::grow()
+{
+    Slot empty_slot = { NULL, 0 };
+    Slots new_slots(slots_.empty()? 16: slots_.size() * 2, empty_slot);
+    size_t mask = new_slots.size() - 1;
+    Slots::const_iterator i = slots_.begin(), iend = slots_.end();
+    for (; i != iend; ++i)
+        if (i->obj) {
+            size_t pos = i->hash & mask;
+            while (new_slots[pos].obj)
+                pos = (pos + 1) & mask;
+            new_slots[pos] = *i;
+        }
+    slots_.swap(new_slots);
+}
+
+DataObject *
+IdentityMap::find(const ObjectKey &key) const
+{
+    if (!size_)
+        return NULL;
+    return slots_[find_slot(key)].obj;
+}
+
+DataObject *
+IdentityMap::insert(const ObjectKey &key, DataObject *obj)
+{
+    YB_ASSERT(obj != NULL);
+    if ((size_ + 1) * 2 > slots_.size())
+        grow();
+    Slot &slot = slots_[find_slot(key)];
+    if (slot.obj)
+        return slot.obj;
+    slot.obj = obj;
+    slot.hash = key.hash();
+    ++size_;
+    return NULL;
+}
+
+bool
+IdentityMap::erase(const ObjectKey &key)
+{
+    if (!size_)
+        return false;
+    size_t mask = slots_.size() - 1, pos = find_slot(key);
+    if (!slots_[pos].obj)
+        return false;
+    // backward shift: move up the following entries of the cluster
+    // that are not at their home slot, so no tombstones are needed
+    size_t next = (pos + 1) & mask;
+    while (slots_[next].obj) {
+        size_t home = slots_[next].hash & mask;
+        if (((next - home) & mask) >= ((next - pos) & mask)) {
+            slots_[pos] = slots_[next];
+            pos = next;
+        }
+        next = (next + 1) & mask;
+    }
+    slots_[pos].obj = NULL;
+    slots_[pos].hash = 0;
+    --size_;
+    return true;
+}
+
+void
+IdentityMap::clear()
+{
+    Slots empty_slots;
+    slots_.swap(empty_slots);
+    size_ = 0;
+}
+
+void
+IdentityMap::swap(IdentityMap &other)
+{
+    slots_.swap(other.slots_);
+    std::swap(size_, other.size_);
+}
+
+} // namespace Yb
+
+// vim:ts=4:sts=4:sw=4:et:
@@ -153,8 +153,36 @@ Table::add_column(const Column &column)
         cols_[idx] = column;
     }
     cols_[idx].set_table(*this);
-    if (column.is_pk())
+    if (column.is_pk()) {
         pk_fields_.push_back(column.name());
+        pk_indexes_.push_back(idx);
+    }
+    clear_plans();
+}
+
+const DmlPlan *
+Table::find_plan(const String &plan_key) const
+{
+    ScopedLock lock(plans_mux_);
+    DmlPlans::const_iterator i = plans_.find(plan_key);
+    if (i == plans_.end())
+        return NULL;
+    return &i->second;
+}
+
+const DmlPlan &
+Table::add_plan(const String &plan_key, const DmlPlan &plan) const
+{
+    ScopedLock lock(plans_mux_);
+    return plans_.insert(DmlPlans::value_type(plan_key, plan)).first->second;
+}
+
+void
+Table::clear_plans()
+{
+    ScopedLock lock(plans_mux_);
+    DmlPlans empty_plans;
+    plans_.swap(empty_plans);
 }
 
 size_t
@@ -183,6 +211,16 @@ Table::get_surrogate_pk() const
     return c.name();
 }
 
+bool
+Table::self_ref() const
+{
+    Columns::const_iterator i = cols_.begin(), iend = cols_.end();
+    for (; i != iend; ++i)
+        if (str_to_upper(i->fk_table_name()) == str_to_upper(name_))
+            return true;
+    return false;
+}
+
 Strings &
 Table::find_fk_for(const Relation &rel, Strings &fkey_parts) const
 {
@@ -245,6 +283,12 @@ Table::mk_key(const Values &row_values, Key &key) const
 
 bool
 Table::mk_key(const Row &row_values, Key &key) const
+{
+    return mk_key(row_values, 0, key);
+}
+
+bool
+Table::mk_key(const Row &row_values, size_t pos, Key &key) const
 {
     key.first = name();
     bool assigned_key = true;
@@ -252,9 +296,13 @@ Table::mk_key(const Row &row_values, Key &key) const
     key_values.reserve(pk_fields().size());
     Strings::const_iterator i = pk_fields().begin(), iend = pk_fields().end();
     for (; i != iend; ++i) {
-        key_values.push_back(make_pair(*i, row_values[idx_by_name(*i)].second));
-        if (key_values[key_values.size() - 1].second.is_null())
+        size_t j = idx_by_name(*i);
+        key_values.push_back(make_pair(*i, row_values[pos + j]));
+        Value &v = key_values[key_values.size() - 1].second;
+        if (v.is_null())
             assigned_key = false;
+        else
+            v.fix_type(cols_[j].type());
     }
     key.second.swap(key_values);
     return assigned_key;
@@ -327,6 +375,14 @@ Relation::attr(int n, const String &name) const {
     return it->second;
 }
 
+int
+Relation::batch_size() const {
+    int n = 1;
+    if (has_non_empty_attr(1, _T("batch-size")))
+        from_string(attr(1, _T("batch-size")), n);
+    return n > 1? n: 1;
+}
+
 bool
 Relation::eq(const Relation &o) {
     /*
@@ -359,6 +415,35 @@ Relation::join_condition() const
     return expr;
 }
 
+const String
+Relation::joined_order_by() const
+{
+    YB_ASSERT(table2_);
+    if (!has_non_empty_attr(1, _T("order-by")))
+        return String();
+    Strings terms, parts;
+    split_str(attr(1, _T("order-by")), _T(","), terms);
+    Strings::const_iterator i = terms.begin(), iend = terms.end();
+    for (; i != iend; ++i) {
+        Strings words;
+        split_str_by_chars(*i, _T(" \t\r\n"), words, 2);
+        if (!words.size())
+            continue;
+        // leave alone qualified names, function calls and positions
+        bool bare = !is_digit(words[0][0]);
+        for (int k = 0; bare && k < (int)str_length(words[0]); ++k) {
+            Char c = words[0][k];
+            bare = is_alpha(c) || is_digit(c) || c == _T('_');
+        }
+        String term = bare?
+            ColumnExpr(table2_->name(), words[0]).get_sql(): words[0];
+        if (words.size() > 1)
+            term += _T(" ") + words[1];
+        parts.push_back(term);
+    }
+    return join_str(_T(", "), parts);
+}
+
 Schema::~Schema()
 {
     clear_backrefs();
@@ -397,6 +482,7 @@ Schema::operator=(Schema &x)
         tables_.swap(x.tables_);
         rels_.swap(x.rels_);
         relations_.swap(x.relations_);
+        std::swap(depths_filled_, x.depths_filled_);
         fix_backrefs();
     }
     return *this;
@@ -414,6 +500,7 @@ Schema::add_table(Table::Ptr table)
     tables_lookup_[str_to_upper(table->name())] = table;
     tables_lookup_[str_to_lower(table->name())] = table;
     table->set_schema(this);
+    depths_filled_ = false;
 }
 
 const Table &
@@ -483,19 +570,30 @@ Schema::fill_fkeys()
                 throw FkNotFoundInMetaData(t0->name(), t1->name());
         }
     }
+    // get the order of inserting rows without validating the schema,
+    // check_cycles() does that and gives the same depths
+    map<String, int> depths;
+    calc_depths(depths, false);
+    set_absolute_depths(depths);
 }
 
 void
 Schema::check_cycles()
+{
+    map<String, int> depths;
+    calc_depths(depths);
+    set_absolute_depths(depths);
+}
+
+void
+Schema::calc_depths(map<String, int> &depths, bool check) const
 {
     set<String> unique_tables;
     fill_unique_tables(unique_tables);
     StrMap tree;
-    map<String, int> depths;
     zero_depths(unique_tables, depths);
-    fill_map_tree_by_meta(unique_tables, tree);
-    traverse_children(tree, depths);
-    set_absolute_depths(depths);
+    fill_map_tree_by_meta(unique_tables, tree, check);
+    traverse_children(tree, depths, check);
 }
 
 const Relation *
@@ -549,10 +647,11 @@ Schema::set_absolute_depths(const map<String, int> &depths)
     map<String, int>::const_iterator it = depths.begin(), end = depths.end();
     for (; it != end; ++it)
         const_cast<Table *> (&table(it->first))->set_depth(it->second);
+    depths_filled_ = true;
 }
 
 void
-Schema::fill_unique_tables(set<String> &unique_tables)
+Schema::fill_unique_tables(set<String> &unique_tables) const
 {
     TblMap::const_iterator it = tables_.begin(), end = tables_.end();
     for (; it != end; ++it)
@@ -560,7 +659,8 @@ Schema::fill_unique_tables(set<String> &unique_tables)
 }
 
 void
-Schema::fill_map_tree_by_meta(const set<String> &unique_tables, StrMap &tree_map)
+Schema::fill_map_tree_by_meta(const set<String> &unique_tables, StrMap &tree_map,
+        bool check) const
 {
     set<String>::const_iterator it = unique_tables.begin(), end = unique_tables.end();
     for (; it != end; ++it) {
@@ -572,9 +672,14 @@ Schema::fill_map_tree_by_meta(const set<String> &unique_tables, StrMap &tree_map
             if (it_col->has_fk()) {
                 String fk_field = it_col->fk_name();
                 String fk_table = it_col->fk_table_name(); 
-                check_foreign_key(t.name(), fk_table, fk_field);
+                if (check)
+                    check_foreign_key(t.name(), fk_table, fk_field);
+                else if (!unique_tables.count(fk_table))
+                    continue;
                 tree_map.insert(StrMap::value_type(it_col->fk_table_name(), t.name()));
-                has_parent = true;
+                // a reference to itself doesn't make the table a slave
+                if (fk_table != t.name())
+                    has_parent = true;
             }
         }
         if (!has_parent)
@@ -586,7 +691,7 @@ Schema::fill_map_tree_by_meta(const set<String> &unique_tables, StrMap &tree_map
 }
 
 void
-Schema::check_foreign_key(const String &table, const String &fk_table, const String &fk_field)
+Schema::check_foreign_key(const String &table, const String &fk_table, const String &fk_field) const
 {
     TblMap::const_iterator i = tables_lookup_.find(fk_table);
     if (const_cast<const TblMap *>(&tables_lookup_)->end() == i)
@@ -604,7 +709,7 @@ Schema::check_foreign_key(const String &table, const String &fk_table, const Str
 }
 
 void
-Schema::zero_depths(const set<String> &unique_tables, map<String, int> &depths)
+Schema::zero_depths(const set<String> &unique_tables, map<String, int> &depths) const
 {
     map<String, int> new_depths;
     set<String>::const_iterator it = unique_tables.begin(), end = unique_tables.end();
@@ -614,7 +719,8 @@ Schema::zero_depths(const set<String> &unique_tables, map<String, int> &depths)
 }
 
 void
-Schema::traverse_children(const StrMap &parent_child, map<String, int> &depths)
+Schema::traverse_children(const StrMap &parent_child, map<String, int> &depths,
+        bool check) const
 {
     list<String> children;
     children.push_back(_T(""));
@@ -625,12 +731,16 @@ Schema::traverse_children(const StrMap &parent_child, map<String, int> &depths)
             const String &parent = range.first->first;
             const String &child = range.first->second;
             if (std::find(children.begin(), children.end(), child) == children.end()) {
-                children.push_back(child);
                 int new_depth = (str_empty(parent)? 0: depths[parent]) + 1;
+                if (new_depth > (int)parent_child.size()) {
+                    if (check)
+                        throw IntegrityCheckFailed(_T("Cyclic references in DB schema found"));
+                    // stop going round the cycle
+                    continue;
+                }
+                children.push_back(child);
                 if (depths[child] < new_depth)
                     depths[child] = new_depth;
-                if (new_depth > (int)parent_child.size())
-                    throw IntegrityCheckFailed(_T("Cyclic references in DB schema found"));
             }
         }
         children.erase(children.begin());
@@ -176,7 +176,7 @@ Relation::Ptr MetaDataConfig::parse_relation(ElementTree::ElementPtr node)
     Relation::AttrMap a1, a2;
     static const char
         *anames_one[] = {"property", "use-list", },
-        *anames_many[] = {"property", "order-by", "key", };
+        *anames_many[] = {"property", "order-by", "key", "batch-size", };
     ElementTree::Elements::const_iterator child = node->children_.begin(),
         cend = node->children_.end();
     for (; child != cend; ++child) {
@@ -413,6 +413,8 @@ ElementTree::ElementPtr MetaDataConfig::relation_to_tree(const Relation &rel)
         node_many->attrib_[_T("key")] = rel.attr(1, _T("key"));
     if (rel.has_non_empty_attr(1, _T("order-by")))
         node_many->attrib_[_T("order-by")] = rel.attr(1, _T("order-by"));
+    if (rel.has_non_empty_attr(1, _T("batch-size")))
+        node_many->attrib_[_T("batch-size")] = rel.attr(1, _T("batch-size"));
     return node;
 }
 
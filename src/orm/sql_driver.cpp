@@ -95,10 +95,76 @@ SqlDialect::select_last_inserted_id(const String &table_name)
     throw SqlDialectError(_T("No autoincrement flag"));
 }
 
+int
+SqlDialect::inserted_id_model()
+{
+    return (int)INSERTED_ID_PER_ROW;
+}
+
 bool SqlDialect::commit_ddl() { return false; }
 
 bool SqlDialect::has_for_update() { return true; }
 
+bool SqlDialect::has_multirow_insert() { return false; }
+
+bool SqlDialect::has_row_value_in() { return false; }
+
+int SqlDialect::max_bind_params() { return 999; }
+
+const String
+SqlDialect::sql_upsert(const String & /* table_name */,
+        const Strings & /* columns */, const Strings & /* key_columns */,
+        const std::vector<Strings> & /* rows_params */)
+{
+    return String();
+}
+
+const String
+SqlDialect::sql_insert_values(const String &table_name,
+        const Strings &columns, const std::vector<Strings> &rows_params)
+{
+    String sql = _T("INSERT INTO ") + table_name + _T(" (")
+        + ExpressionList(columns).get_sql() + _T(") VALUES ");
+    for (size_t i = 0; i < rows_params.size(); ++i) {
+        if (i)
+            sql += _T(", ");
+        sql += _T("(") + ExpressionList(rows_params[i]).get_sql() + _T(")");
+    }
+    return sql;
+}
+
+const String
+SqlDialect::sql_on_conflict_update(const String &table_name,
+        const Strings &columns, const Strings &key_columns,
+        const std::vector<Strings> &rows_params)
+{
+    String sql = sql_insert_values(table_name, columns, rows_params)
+        + _T(" ON CONFLICT (") + ExpressionList(key_columns).get_sql()
+        + _T(") DO ");
+    Strings data_cols = non_key_columns(columns, key_columns);
+    if (!data_cols.size())
+        return sql + _T("NOTHING");
+    sql += _T("UPDATE SET ");
+    for (size_t i = 0; i < data_cols.size(); ++i) {
+        if (i)
+            sql += _T(", ");
+        sql += data_cols[i] + _T(" = excluded.") + data_cols[i];
+    }
+    return sql;
+}
+
+const Strings
+SqlDialect::non_key_columns(const Strings &columns,
+        const Strings &key_columns)
+{
+    Strings result;
+    for (size_t i = 0; i < columns.size(); ++i)
+        if (std::find(key_columns.begin(), key_columns.end(), columns[i])
+                == key_columns.end())
+            result.push_back(columns[i]);
+    return result;
+}
+
 bool SqlDialect::fk_internal() { return false; }
 
 const String SqlDialect::suffix_create_table() { return String(); }
@@ -261,6 +327,34 @@ SqlCursorBackend::~SqlCursorBackend() {}
 void
 SqlCursorBackend::bind_params(const TypeCodes &types) {}
 
+void
+SqlCursorBackend::exec_many(const std::vector<Values> &params_list)
+{
+    std::vector<Values>::const_iterator i = params_list.begin(),
+        iend = params_list.end();
+    for (; i != iend; ++i)
+        exec(*i);
+}
+
+size_t
+SqlCursorBackend::fetch_block(RowBlock &block, size_t n)
+{
+    size_t count = 0;
+    for (; count < n; ++count) {
+        RowPtr row = fetch_row();
+        if (!row.get())
+            break;
+        block.add_row().swap(*row);
+    }
+    return count;
+}
+
+bool
+SqlCursorBackend::last_insert_id(LongInt & /* id */) { return false; }
+
+void
+SqlCursorBackend::reset() {}
+
 SqlConnectionBackend::~SqlConnectionBackend() {}
 
 SqlDriver::~SqlDriver() {}
@@ -385,6 +479,79 @@ SqlSource::options() const
     return options;
 }
 
+RowHeader::RowHeader(const Strings &names)
+{
+    for (size_t i = 0; i < names.size(); ++i)
+        add(names[i]);
+}
+
+void
+RowHeader::add(const String &name)
+{
+    String uname = str_to_upper(name);
+    // the first one wins when a name repeats
+    index_.insert(Index::value_type(uname, (int)names_.size()));
+    names_.push_back(uname);
+}
+
+int
+RowHeader::find(const String &name) const
+{
+    Index::const_iterator i = index_.find(name);
+    if (i == index_.end()) {
+        i = index_.find(str_to_upper(name));
+        if (i == index_.end())
+            return -1;
+    }
+    return i->second;
+}
+
+Row::Row(const RowHeaderPtr &header)
+    : header_(header)
+    , values_(header->size())
+{}
+
+int
+Row::find(const String &name) const
+{
+    if (!shptr_get(header_))
+        return -1;
+    return header_->find(name);
+}
+
+Value &
+Row::get(const String &name)
+{
+    int i = find(name);
+    if (i < 0)
+        throw NoDataFound(_T("No column in the row: ") + name);
+    return values_[i];
+}
+
+const Value &
+Row::get(const String &name) const
+{
+    int i = find(name);
+    if (i < 0)
+        throw NoDataFound(_T("No column in the row: ") + name);
+    return values_[i];
+}
+
+void
+Row::reset(const RowHeaderPtr &header)
+{
+    if (shptr_get(header_) != shptr_get(header))
+        header_ = header;
+    values_.resize(header->size());
+}
+
+void
+Row::swap(Row &other)
+{
+    std::swap(header_, other.header_);
+    values_.swap(other.values_);
+}
+
 bool
 SqlResultSet::fetch(Row &row)
 {
@@ -402,6 +569,12 @@ SqlResultSet::own(std::auto_ptr<SqlCursor> cursor)
     owned_cursor_.reset(cursor.release());
 }
 
+size_t
+SqlResultSet::fetch_block(RowBlock &block, size_t n)
+{
+    return cursor_.fetch_block(block, n);
+}
+
 SqlCursor::SqlCursor(SqlConnection &connection)
     : connection_(connection)
     , backend_(connection.backend_->new_cursor().release())
@@ -410,6 +583,28 @@ SqlCursor::SqlCursor(SqlConnection &connection)
     , log_(connection.log_.get())
 {}
 
+SqlCursor::~SqlCursor()
+{
+    if (!str_empty(sql_)) {
+        try {
+            connection_.put_stmt(sql_, backend_);
+        }
+        catch (const std::exception &) {}
+    }
+}
+
+void
+SqlCursor::release_stmt()
+{
+    if (str_empty(sql_))
+        return;
+    String sql;
+    str_swap(sql, sql_);
+    // give the prepared statement away to the connection's cache
+    if (connection_.put_stmt(sql, backend_))
+        backend_.reset(connection_.backend_->new_cursor().release());
+}
+
 void
 SqlCursor::exec_direct(const String &sql)
 {
@@ -417,6 +612,7 @@ SqlCursor::exec_direct(const String &sql)
         if (echo_)
             debug(_T("exec_direct: ") + sql);
         connection_.activity_ = true;
+        release_stmt();
         backend_->exec_direct(sql);
     }
     catch (const std::exception &e) {
@@ -432,10 +628,30 @@ SqlCursor::prepare(const String &sql)
         String fixed_sql = sql;
         if (conv_params_ && connection_.driver_->numbered_params())
             fixed_sql = SqlDriver::convert_to_numbered_params(sql);
+        connection_.activity_ = true;
+        if (connection_.stmt_cache_size_ > 0) {
+            if (fixed_sql == sql_) {
+                if (echo_)
+                    debug(_T("prepare (reuse): ") + fixed_sql);
+                backend_->reset();
+                return;
+            }
+            release_stmt();
+            std::auto_ptr<SqlCursorBackend> cached =
+                connection_.take_stmt(fixed_sql);
+            if (cached.get()) {
+                if (echo_)
+                    debug(_T("prepare (cached): ") + fixed_sql);
+                backend_.reset(cached.release());
+                sql_ = fixed_sql;
+                return;
+            }
+        }
         if (echo_)
             debug(_T("prepare: ") + fixed_sql);
-        connection_.activity_ = true;
         backend_->prepare(fixed_sql);
+        if (connection_.stmt_cache_size_ > 0)
+            sql_ = fixed_sql;
     }
     catch (const std::exception &e) {
         connection_.mark_bad(e);
@@ -486,33 +702,54 @@ SqlCursor::exec(const Values &params)
     }
 }
 
-RowPtr
-SqlCursor::fetch_row()
+void
+SqlCursor::exec_many(const std::vector<Values> &params_list)
 {
     try {
-        RowPtr row = backend_->fetch_row();
-        if (row.get()) {
-            Row::iterator j = row->begin(), jend = row->end();
-            for (; j != jend; ++j) {
-                String uname = str_to_upper(j->first);
-                using namespace std;
-                swap(j->first, uname);
-            }
-        }
         if (echo_) {
-            if (row.get()) {
-                std::ostringstream out;
-                out << "fetch: ";
-                Row::const_iterator j = row->begin(),
-                                    jend = row->end();
-                for (; j != jend; ++j)
-                    out << NARROW(j->first) << "="
-                        << NARROW(j->second.sql_str()) << " ";
-                debug(WIDEN(out.str()));
+            std::ostringstream out;
+            out << "exec prepared " << params_list.size() << " times:";
+            for (size_t k = 0; k < params_list.size(); ++k) {
+                const Values &params = params_list[k];
+                out << " [";
+                for (size_t i = 0; i < params.size(); ++i)
+                    out << (i? " p": "p") << (i + 1) << "=\""
+                        << NARROW(params[i].sql_str()) << "\"";
+                out << "]";
             }
-            else
-                debug(_T("fetch: no more rows"));
+            debug(WIDEN(out.str()));
         }
+        connection_.activity_ = true;
+        backend_->exec_many(params_list);
+    }
+    catch (const std::exception &e) {
+        connection_.mark_bad(e);
+        throw;
+    }
+}
+
+void
+SqlCursor::echo_row(const Row *row)
+{
+    if (row) {
+        std::ostringstream out;
+        out << "fetch: ";
+        for (size_t j = 0; j < row->size(); ++j)
+            out << NARROW(row->name(j)) << "="
+                << NARROW((*row)[j].sql_str()) << " ";
+        debug(WIDEN(out.str()));
+    }
+    else
+        debug(_T("fetch: no more rows"));
+}
+
+RowPtr
+SqlCursor::fetch_row()
+{
+    try {
+        RowPtr row = backend_->fetch_row();
+        if (echo_)
+            echo_row(row.get());
         return row;
     }
     catch (const std::exception &e) {
@@ -527,8 +764,8 @@ SqlCursor::fetch_rows(int max_rows)
     try {
         RowsPtr rows(new Rows);
         SqlResultSet result(*this);
-        copy_no_more_than_n(result.begin(), result.end(),
-                            max_rows, back_inserter(*rows));
+        move_no_more_than_n(result.begin(), result.end(),
+                            max_rows, *rows);
         return rows;
     }
     catch (const std::exception &e) {
@@ -537,6 +774,43 @@ SqlCursor::fetch_rows(int max_rows)
     }
 }
 
+size_t
+SqlCursor::fetch_block(RowBlock &block, size_t n)
+{
+    try {
+        if (!n)
+            n = connection_.row_block();
+        block.clear();
+        size_t count = backend_->fetch_block(block, n);
+        if (echo_) {
+            for (size_t i = 0; i < count; ++i)
+                echo_row(&block[i]);
+            if (count < n)
+                echo_row(NULL);
+        }
+        return count;
+    }
+    catch (const std::exception &e) {
+        connection_.mark_bad(e);
+        throw;
+    }
+}
+
+bool
+SqlCursor::last_insert_id(LongInt &id)
+{
+    try {
+        bool found = backend_->last_insert_id(id);
+        if (echo_ && found)
+            debug(_T("last insert id: ") + to_string(id));
+        return found;
+    }
+    catch (const std::exception &e) {
+        connection_.mark_bad(e);
+        throw;
+    }
+}
+
 void
 SqlConnection::mark_bad(const std::exception &e)
 {
@@ -547,9 +821,54 @@ SqlConnection::mark_bad(const std::exception &e)
             s = s.substr(0, pos);
         debug(_T("mark connection bad, because of ") + String(WIDEN(s)));
         bad_ = true;
+        shrink_stmt_cache(0);
+    }
+}
+
+std::auto_ptr<SqlCursorBackend>
+SqlConnection::take_stmt(const String &sql)
+{
+    std::auto_ptr<SqlCursorBackend> backend;
+    StmtIndex::iterator i = stmt_index_.find(sql);
+    if (i != stmt_index_.end()) {
+        backend.reset(i->second->second);
+        stmt_lru_.erase(i->second);
+        stmt_index_.erase(i);
+    }
+    return backend;
+}
+
+bool
+SqlConnection::put_stmt(const String &sql,
+        std::auto_ptr<SqlCursorBackend> &backend)
+{
+    if (bad_ || stmt_cache_size_ <= 0)
+        return false;
+    backend->reset();
+    std::auto_ptr<SqlCursorBackend> prev = take_stmt(sql);
+    stmt_lru_.push_front(std::make_pair(sql, backend.release()));
+    stmt_index_[sql] = stmt_lru_.begin();
+    shrink_stmt_cache(stmt_cache_size_);
+    return true;
+}
+
+void
+SqlConnection::shrink_stmt_cache(size_t size)
+{
+    while (stmt_lru_.size() > size) {
+        std::auto_ptr<SqlCursorBackend> backend(stmt_lru_.back().second);
+        stmt_index_.erase(stmt_lru_.back().first);
+        stmt_lru_.pop_back();
     }
 }
 
+void
+SqlConnection::set_stmt_cache_size(int size)
+{
+    stmt_cache_size_ = size > 0? size: 0;
+    shrink_stmt_cache(stmt_cache_size_);
+}
+
 SqlConnection::SqlConnection(const String &driver_name,
         const String &dialect_name, const String &db,
         const String &user, const String &passwd)
@@ -561,11 +880,19 @@ SqlConnection::SqlConnection(const String &driver_name,
     , conv_params_(false)
     , bad_(false)
     , explicit_trans_started_(false)
+    , consecutive_ids_(false)
     , free_since_(0)
+    , insert_batch_(1)
+    , delete_batch_(1)
+    , max_bind_params_(0)
+    , stmt_cache_size_(0)
+    , param_array_(1)
+    , row_block_(1)
 {
     source_[_T("&driver")] = driver_->get_name();
     backend_.reset(driver_->create_backend().release());
     backend_->open(dialect_, source_);
+    init_options();
 }
 
 SqlConnection::SqlConnection(const String &driver_name,
@@ -579,11 +906,19 @@ SqlConnection::SqlConnection(const String &driver_name,
     , conv_params_(false)
     , bad_(false)
     , explicit_trans_started_(false)
+    , consecutive_ids_(false)
     , free_since_(0)
+    , insert_batch_(1)
+    , delete_batch_(1)
+    , max_bind_params_(0)
+    , stmt_cache_size_(0)
+    , param_array_(1)
+    , row_block_(1)
 {
     source_[_T("&driver")] = driver_->get_name();
     backend_.reset(driver_->create_backend().release());
     backend_->use_raw(dialect_, raw_connection);
+    init_options();
 }
 
 SqlConnection::SqlConnection(const SqlSource &source)
@@ -595,11 +930,19 @@ SqlConnection::SqlConnection(const SqlSource &source)
     , conv_params_(false)
     , bad_(false)
     , explicit_trans_started_(false)
+    , consecutive_ids_(false)
     , free_since_(0)
+    , insert_batch_(1)
+    , delete_batch_(1)
+    , max_bind_params_(0)
+    , stmt_cache_size_(0)
+    , param_array_(1)
+    , row_block_(1)
 {
     source_[_T("&driver")] = driver_->get_name();
     backend_.reset(driver_->create_backend().release());
     backend_->open(dialect_, source_);
+    init_options();
 }
 
 SqlConnection::SqlConnection(const String &url)
@@ -611,11 +954,36 @@ SqlConnection::SqlConnection(const String &url)
     , conv_params_(false)
     , bad_(false)
     , explicit_trans_started_(false)
+    , consecutive_ids_(false)
     , free_since_(0)
+    , insert_batch_(1)
+    , delete_batch_(1)
+    , max_bind_params_(0)
+    , stmt_cache_size_(0)
+    , param_array_(1)
+    , row_block_(1)
 {
     source_[_T("&driver")] = driver_->get_name();
     backend_.reset(driver_->create_backend().release());
     backend_->open(dialect_, source_);
+    init_options();
+}
+
+void
+SqlConnection::init_options()
+{
+    set_insert_batch(source_.get_as<int>(String(_T("insert_batch")), 1));
+    set_consecutive_ids(
+            source_.get_as<int>(String(_T("consecutive_ids")), 0) != 0);
+    set_delete_batch(source_.get_as<int>(String(_T("delete_batch")), 100));
+    set_stmt_cache_size(source_.get_as<int>(String(_T("stmt_cache")), 0));
+    set_param_array(source_.get_as<int>(String(_T("param_array")), 100));
+    set_row_block(source_.get_as<int>(String(_T("row_block")), 64));
+    max_bind_params_ = dialect_->max_bind_params();
+    int max_params = source_.get_as<int>(String(_T("max_params")), 0);
+    if (max_params > 0 && (max_bind_params_ <= 0
+                || max_params < max_bind_params_))
+        max_bind_params_ = max_params;
 }
 
 SqlConnection::~SqlConnection()
@@ -629,6 +997,7 @@ SqlConnection::~SqlConnection()
     catch (const std::exception &) {
         err = true;
     }
+    shrink_stmt_cache(0);
     if (source_.id() != _T("#raw_connection")) {
         try {
             backend_->close();
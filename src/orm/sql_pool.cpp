@@ -200,6 +200,10 @@ SqlPool::~SqlPool()
     stop_monitor_thread();
     monitor_.wait();
     close_all();
+    IdAllocators::iterator i = id_allocators_.begin(),
+        iend = id_allocators_.end();
+    for (; i != iend; ++i)
+        delete i->second;
 }
 
 void
@@ -261,6 +265,29 @@ SqlPool::get(const String &id, int timeout)
     return handle;
 }
 
+IdAllocator *
+SqlPool::id_allocator(const String &id)
+{
+    std::map<String, SqlSource>::iterator src = sources_.find(id);
+    if (sources_.end() == src)
+        throw PoolError(_T("Unknown source ID: ") + id);
+    ScopedLock lock(pool_mux_);
+    IdAllocator *&allocator = id_allocators_[id];
+    if (!allocator)
+        allocator = new_id_allocator(src->second).release();
+    return allocator;
+}
+
+void
+SqlPool::set_id_allocator(const String &id,
+        std::auto_ptr<IdAllocator> allocator)
+{
+    ScopedLock lock(pool_mux_);
+    IdAllocator *&old_allocator = id_allocators_[id];
+    delete old_allocator;
+    old_allocator = allocator.release();
+}
+
 void
 SqlPool::put(SqlConnectionPtr handle, bool close_now, bool new_conn)
 {
@@ -644,6 +644,281 @@ namespace tiodbc
 		set_as_string(_tstring(), true);
 	}
 
+	///////////////////////////////////////////////////////////////////////////////////
+	// PARAM ARRAY IMPLEMENTATION
+	///////////////////////////////////////////////////////////////////////////////////
+
+	// Constructor
+	param_array::param_array(int _rows)
+		: rows(_rows > 0? _rows: 1)
+	{}
+
+	// Get column, add columns as needed
+	param_array::column & param_array::get_column(int _par_num)
+	{
+		if ((int)m_cols.size() < _par_num) {
+			column empty_col;
+			empty_col.c_type = SQL_C_TCHAR;
+			empty_col.sql_type = SQL_CHAR;
+			empty_col.col_size = 0;
+			empty_col.elem_sz = 0;
+			empty_col.ind.resize(rows, SQL_NULL_DATA);
+			m_cols.resize(_par_num, empty_col);
+		}
+		return m_cols[_par_num - 1];
+	}
+
+	// Get the buffer for a value, the first non-NULL value fixes the type
+	void * param_array::slot(int _par_num, int _row,
+			SQLSMALLINT _ctype, SQLSMALLINT _sqltype,
+			SQLLEN _elem_sz, SQLULEN _col_size)
+	{
+		column &col = get_column(_par_num);
+		if (!col.elem_sz) {
+			col.c_type = _ctype;
+			col.sql_type = _sqltype;
+			col.col_size = _col_size;
+			col.elem_sz = _elem_sz;
+			col.data.resize(rows * _elem_sz);
+		}
+		else if (col.c_type != _ctype)
+			return NULL;
+		else if (col.elem_sz < _elem_sz) {
+			// Widen the buffer of a string parameter
+			SQLLEN new_sz = col.elem_sz * 2;
+			if (new_sz < _elem_sz)
+				new_sz = _elem_sz;
+			std::vector<char> new_data(rows * new_sz);
+			for (int i = 0; i < rows; ++i)
+				std::memcpy(&new_data[i * new_sz],
+						&col.data[i * col.elem_sz], col.elem_sz);
+			col.data.swap(new_data);
+			col.elem_sz = new_sz;
+		}
+		col.ind[_row] = 0;
+		return &col.data[_row * col.elem_sz];
+	}
+
+	bool param_array::set_as_string(int _par_num, int _row, const _tstring & _str)
+	{
+		SQLTCHAR_buf data(ybstring2sqltchar(_str, ""));
+		SQLLEN data_sz = data.len * sizeof(SQLTCHAR);
+		void *buf = slot(_par_num, _row, SQL_C_TCHAR, SQL_CHAR, data_sz);
+		if (!buf)
+			return false;
+		std::memcpy(buf, data.data, data_sz);
+		m_cols[_par_num - 1].ind[_row] = SQL_NTS;
+		return true;
+	}
+
+	bool param_array::set_as_long(int _par_num, int _row, const long & _value)
+	{
+		SQLINTEGER x = (SQLINTEGER)_value;
+		void *buf = slot(_par_num, _row, SQL_C_SLONG, SQL_INTEGER, sizeof(x));
+		if (!buf)
+			return false;
+		std::memcpy(buf, &x, sizeof(x));
+		return true;
+	}
+
+	bool param_array::set_as_long_long(int _par_num, int _row,
+			const LongLong & _value)
+	{
+		void *buf = slot(_par_num, _row, SQL_C_SBIGINT, SQL_BIGINT,
+				sizeof(_value));
+		if (!buf)
+			return false;
+		std::memcpy(buf, &_value, sizeof(_value));
+		return true;
+	}
+
+	bool param_array::set_as_double(int _par_num, int _row, const double & _value)
+	{
+		void *buf = slot(_par_num, _row, SQL_C_DOUBLE, SQL_DOUBLE,
+				sizeof(_value));
+		if (!buf)
+			return false;
+		std::memcpy(buf, &_value, sizeof(_value));
+		return true;
+	}
+
+	bool param_array::set_as_date_time(int _par_num, int _row,
+			const TIMESTAMP_STRUCT & _value)
+	{
+		if (_value.year == 0) {
+			set_as_null(_par_num, _row);
+			return true;
+		}
+		const int odbc_date_prec = 23;
+		void *buf = slot(_par_num, _row, SQL_C_TYPE_TIMESTAMP,
+				SQL_TYPE_TIMESTAMP, sizeof(_value), odbc_date_prec);
+		if (!buf)
+			return false;
+		std::memcpy(buf, &_value, sizeof(_value));
+		return true;
+	}
+
+	void param_array::set_as_null(int _par_num, int _row)
+	{
+		get_column(_par_num).ind[_row] = SQL_NULL_DATA;
+	}
+
+	///////////////////////////////////////////////////////////////////////////////////
+	// ROW ARRAY IMPLEMENTATION
+	///////////////////////////////////////////////////////////////////////////////////
+
+	//! @cond INTERNAL_FUNCTIONS
+	inline SQLLEN __align(SQLLEN _sz)
+	{
+		const SQLLEN a = 8;
+		return (_sz + a - 1) / a * a;
+	}
+	//! @endcond
+
+	// Read a numeric value converting from the buffer type
+	template <class T>
+	T bound_field::get_as() const
+	{
+		if (is_null())
+			return T();
+		switch (c_type) {
+			case SQL_C_SLONG: {
+				SQLINTEGER x;
+				std::memcpy(&x, buf, sizeof(x));
+				return (T)x;
+			}
+			case SQL_C_SBIGINT: {
+				LongLong x;
+				std::memcpy(&x, buf, sizeof(x));
+				return (T)x;
+			}
+			case SQL_C_DOUBLE: {
+				double x;
+				std::memcpy(&x, buf, sizeof(x));
+				return (T)x;
+			}
+		}
+		return T();
+	}
+
+	// Get field as string
+	_tstring bound_field::as_string() const
+	{
+		if (is_null())
+			return _tstring();
+		return sqltchar2ybstring((const SQLTCHAR *)buf, "");
+	}
+
+	// Get field as long
+	long bound_field::as_long() const
+	{
+		return get_as<long>();
+	}
+
+	// Get field as long long
+	LongLong bound_field::as_long_long() const
+	{
+		return get_as<LongLong>();
+	}
+
+	// Get field as double
+	double bound_field::as_double() const
+	{
+		return get_as<double>();
+	}
+
+	// Get field as TIMESTAMP_STRUCT
+	const TIMESTAMP_STRUCT bound_field::as_date_time() const
+	{
+		TIMESTAMP_STRUCT x;
+		if (is_null() || c_type != SQL_C_TIMESTAMP)
+			std::memset(&x, 0, sizeof(x));
+		else
+			std::memcpy(&x, buf, sizeof(x));
+		return x;
+	}
+
+	// Constructor
+	row_array::row_array(int _rows, SQLLEN _max_col_sz)
+		: max_rows(_rows > 0? _rows: 1)
+		, block_rows(1)
+		, max_col_sz(_max_col_sz)
+		, row_sz(0)
+		, rows_fetched(0)
+	{}
+
+	// Choose the buffer types and sizes, lay out the row records
+	void row_array::layout(const std::vector<SQLSMALLINT> & _types,
+			const std::vector<SQLULEN> & _sizes)
+	{
+		m_cols.clear();
+		row_sz = 0;
+		for (size_t i = 0; i < _types.size(); ++i) {
+			column col;
+			col.sql_type = _types[i];
+			switch (_types[i]) {
+				case SQL_INTEGER:
+				case SQL_SMALLINT:
+				case SQL_TINYINT:
+					col.c_type = SQL_C_SLONG;
+					col.elem_sz = sizeof(SQLINTEGER);
+					break;
+				case SQL_BIGINT:
+					col.c_type = SQL_C_SBIGINT;
+					col.elem_sz = sizeof(LongLong);
+					break;
+				case SQL_REAL:
+				case SQL_FLOAT:
+				case SQL_DOUBLE:
+					col.c_type = SQL_C_DOUBLE;
+					col.elem_sz = sizeof(double);
+					break;
+				case SQL_DATE:
+				case SQL_TIMESTAMP:
+				case SQL_TYPE_DATE:
+				case SQL_TYPE_TIME:
+				case SQL_TYPE_TIMESTAMP:
+					col.c_type = SQL_C_TIMESTAMP;
+					col.elem_sz = sizeof(TIMESTAMP_STRUCT);
+					break;
+				case SQL_DECIMAL:
+				case SQL_NUMERIC:
+					// digits, sign, decimal point and terminator
+					col.c_type = SQL_C_TCHAR;
+					col.elem_sz = (_sizes[i] + 3) * sizeof(SQLTCHAR);
+					break;
+				default:
+					// column size is in characters, a character
+					// may take several SQLTCHARs
+					col.c_type = SQL_C_TCHAR;
+					col.elem_sz = _sizes[i]?
+						(_sizes[i] * (sizeof(SQLTCHAR) == 1? 4: 2) + 1)
+							* sizeof(SQLTCHAR): 0;
+			}
+			if (!col.elem_sz || col.elem_sz > max_col_sz)
+				break;
+			// each value is preceded by its indicator
+			col.offset = row_sz + __align(sizeof(SQLLEN));
+			row_sz = col.offset + __align(col.elem_sz);
+			m_cols.push_back(col);
+		}
+		block_rows = m_cols.size() == _types.size()? max_rows: 1;
+		data.resize(row_sz * block_rows);
+		status.resize(block_rows);
+		rows_fetched = 0;
+	}
+
+	// Get a bound field
+	const bound_field row_array::field(int _col, int _row) const
+	{
+		const column &col = m_cols[_col - 1];
+		const char *rec = &data[_row * row_sz];
+		SQLLEN ind;
+		std::memcpy(&ind, rec + col.offset - __align(sizeof(SQLLEN)),
+				sizeof(ind));
+		return bound_field(rec + col.offset, ind, col.sql_type, col.c_type);
+	}
+
 	///////////////////////////////////////////////////////////////////////////////////
 	// STATEMENT IMPLEMENTATION
 	///////////////////////////////////////////////////////////////////////////////////
@@ -652,7 +927,9 @@ namespace tiodbc
 	statement::statement()
 		:stmt_h(NULL),
 		b_open(false),
-		b_col_info_needed(false)
+		b_col_info_needed(false),
+		b_param_array(false),
+		b_row_array(false)
 	{
 	}
 
@@ -660,7 +937,9 @@ namespace tiodbc
 	statement::statement(connection & _conn, const _tstring & _stmt)
 		:stmt_h(NULL),
 		b_open(false),
-		b_col_info_needed(false)
+		b_col_info_needed(false),
+		b_param_array(false),
+		b_row_array(false)
 	{
 		prepare(_conn, _stmt);
 	}
@@ -684,6 +963,8 @@ namespace tiodbc
 		{
 			stmt_h = NULL;
 			b_open = false;
+			b_param_array = false;
+			b_row_array = false;
 			return false;
 		}
 
@@ -709,6 +990,8 @@ namespace tiodbc
 			SQLFreeHandle(SQL_HANDLE_STMT, stmt_h);
 			stmt_h = NULL;
 			b_open = false;
+			b_param_array = false;
+			b_row_array = false;
 		}
 	}
 
@@ -771,6 +1054,8 @@ namespace tiodbc
 		if (!is_open())
 			return false;
 
+		if (b_param_array)
+			reset_param_array();
 		rc = SQLExecute(stmt_h);
 		if (!TIODBC_SUCCESS_CODE(rc)) {
 			if (rc == SQL_NEED_DATA) {
@@ -786,6 +1071,92 @@ namespace tiodbc
 		return true;
 	}
 
+	// Execute statement for an array of parameter sets
+	bool statement::execute_array(param_array & _params)
+	{
+		RETCODE rc;
+		if (!is_open())
+			return false;
+
+		// Parameters set with param() are bound to their own buffers
+		for (param_it it = m_params.begin(); it != m_params.end(); ++it)
+			delete it->second;
+		m_params.clear();
+		SQLFreeStmt(stmt_h, SQL_RESET_PARAMS);
+		b_param_array = true;
+
+		std::vector<param_array::column> &cols = _params.m_cols;
+		for (size_t i = 0; i < cols.size(); ++i) {
+			if (!cols[i].elem_sz) {
+				// NULLs only
+				cols[i].elem_sz = sizeof(SQLTCHAR);
+				cols[i].data.resize(_params.rows * cols[i].elem_sz);
+			}
+		}
+
+		SQLULEN rows = _params.rows, processed = 0;
+		std::vector<SQLUSMALLINT> status(rows, SQL_PARAM_UNUSED);
+		bool use_array = rows > 1;
+		if (use_array) {
+			rc = SQLSetStmtAttr(stmt_h, SQL_ATTR_PARAM_BIND_TYPE,
+					(SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0);
+			if (rc == SQL_SUCCESS)
+				rc = SQLSetStmtAttr(stmt_h, SQL_ATTR_PARAMSET_SIZE,
+						(SQLPOINTER)rows, 0);
+			// A driver may substitute its own array size with a warning,
+			// then the sets are executed one by one below
+			use_array = rc == SQL_SUCCESS;
+		}
+		if (use_array) {
+			SQLSetStmtAttr(stmt_h, SQL_ATTR_PARAM_STATUS_PTR, &status[0], 0);
+			SQLSetStmtAttr(stmt_h, SQL_ATTR_PARAMS_PROCESSED_PTR, &processed, 0);
+			for (size_t i = 0; i < cols.size(); ++i) {
+				param_array::column &col = cols[i];
+				rc = SQLBindParameter(stmt_h, (SQLUSMALLINT)(i + 1),
+						SQL_PARAM_INPUT, col.c_type, col.sql_type,
+						col.col_size, 0, &col.data[0], col.elem_sz, &col.ind[0]);
+				if (!TIODBC_SUCCESS_CODE(rc))
+					return false;
+			}
+			rc = SQLExecute(stmt_h);
+			if (!TIODBC_SUCCESS_CODE(rc))
+				return false;
+			for (SQLULEN j = 0; j < processed; ++j)
+				if (status[j] == SQL_PARAM_ERROR)
+					return false;
+			b_col_info_needed = true;
+			return processed == rows;
+		}
+		SQLSetStmtAttr(stmt_h, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+		for (SQLULEN j = 0; j < rows; ++j) {
+			for (size_t i = 0; i < cols.size(); ++i) {
+				param_array::column &col = cols[i];
+				rc = SQLBindParameter(stmt_h, (SQLUSMALLINT)(i + 1),
+						SQL_PARAM_INPUT, col.c_type, col.sql_type,
+						col.col_size, 0, &col.data[j * col.elem_sz],
+						col.elem_sz, &col.ind[j]);
+				if (!TIODBC_SUCCESS_CODE(rc))
+					return false;
+			}
+			rc = SQLExecute(stmt_h);
+			if (!TIODBC_SUCCESS_CODE(rc) && rc != SQL_NO_DATA)
+				return false;
+			SQLFreeStmt(stmt_h, SQL_CLOSE);
+		}
+		b_col_info_needed = true;
+		return true;
+	}
+
+	// Return to single parameter set mode after execute_array()
+	void statement::reset_param_array()
+	{
+		SQLFreeStmt(stmt_h, SQL_RESET_PARAMS);
+		SQLSetStmtAttr(stmt_h, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)1, 0);
+		SQLSetStmtAttr(stmt_h, SQL_ATTR_PARAM_STATUS_PTR, NULL, 0);
+		SQLSetStmtAttr(stmt_h, SQL_ATTR_PARAMS_PROCESSED_PTR, NULL, 0);
+		b_param_array = false;
+	}
+
 	bool statement::describe_cols()
 	{
 		RETCODE rc;
@@ -823,6 +1194,8 @@ namespace tiodbc
 			b_col_info_needed = false;
 			describe_cols();
 		}
+		if (b_row_array)
+			reset_row_array();
 
 		rc = SQLFetch(stmt_h);
 		if (TIODBC_SUCCESS_CODE(rc))
@@ -830,6 +1203,86 @@ namespace tiodbc
 		return false;
 	}
 
+	// Bind result columns to row array buffers
+	bool statement::bind_array(row_array & _rows)
+	{
+		RETCODE rc;
+		if (!is_open())
+			return false;
+
+		if (b_col_info_needed) {
+			b_col_info_needed = false;
+			if (!describe_cols())
+				return false;
+		}
+		if (b_row_array)
+			reset_row_array();
+
+		std::vector<SQLSMALLINT> types(m_cols.size());
+		std::vector<SQLULEN> sizes(m_cols.size());
+		for (size_t i = 0; i < m_cols.size(); ++i) {
+			types[i] = m_cols[i].type;
+			sizes[i] = m_cols[i].col_size;
+		}
+		_rows.layout(types, sizes);
+		b_row_array = true;
+		if (!_rows.count_bound())
+			return true;
+
+		rc = SQLSetStmtAttr(stmt_h, SQL_ATTR_ROW_BIND_TYPE,
+				(SQLPOINTER)_rows.row_sz, 0);
+		if (!TIODBC_SUCCESS_CODE(rc))
+			return false;
+		rc = SQLSetStmtAttr(stmt_h, SQL_ATTR_ROW_ARRAY_SIZE,
+				(SQLPOINTER)(SQLULEN)_rows.block_rows, 0);
+		if (rc != SQL_SUCCESS) {
+			// The driver can't fetch this many rows at once
+			_rows.block_rows = 1;
+			SQLSetStmtAttr(stmt_h, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+		}
+		SQLSetStmtAttr(stmt_h, SQL_ATTR_ROWS_FETCHED_PTR,
+				&_rows.rows_fetched, 0);
+		SQLSetStmtAttr(stmt_h, SQL_ATTR_ROW_STATUS_PTR, &_rows.status[0], 0);
+		for (size_t i = 0; i < _rows.m_cols.size(); ++i) {
+			row_array::column &col = _rows.m_cols[i];
+			char *rec = &_rows.data[0];
+			rc = SQLBindCol(stmt_h, (SQLUSMALLINT)(i + 1), col.c_type,
+					rec + col.offset, col.elem_sz,
+					(SQLLEN *)(rec + col.offset - __align(sizeof(SQLLEN))));
+			if (!TIODBC_SUCCESS_CODE(rc))
+				return false;
+		}
+		return true;
+	}
+
+	// Fetch a block of rows
+	int statement::fetch_array(row_array & _rows)
+	{
+		RETCODE rc;
+		if (!is_open() || !b_row_array)
+			return 0;
+
+		_rows.rows_fetched = 0;
+		rc = SQLFetch(stmt_h);
+		if (!TIODBC_SUCCESS_CODE(rc))
+			return 0;
+		if (!_rows.count_bound())
+			return 1;	// everything is read with field()
+		return (int)_rows.rows_fetched;
+	}
+
+	// Return to unbound single row fetch mode after bind_array()
+	void statement::reset_row_array()
+	{
+		SQLFreeStmt(stmt_h, SQL_UNBIND);
+		SQLSetStmtAttr(stmt_h, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+		SQLSetStmtAttr(stmt_h, SQL_ATTR_ROWS_FETCHED_PTR, NULL, 0);
+		SQLSetStmtAttr(stmt_h, SQL_ATTR_ROW_STATUS_PTR, NULL, 0);
+		SQLSetStmtAttr(stmt_h, SQL_ATTR_ROW_BIND_TYPE,
+				(SQLPOINTER)SQL_BIND_BY_COLUMN, 0);
+		b_row_array = false;
+	}
+
 	// Get a field by column number (1-based)
 	const field_impl statement::field(int _num) const
 	{
@@ -887,6 +1340,8 @@ namespace tiodbc
 	// Handle a parameter
 	param_impl & statement::param(int _num)
 	{
+		if (b_param_array)
+			reset_param_array();
 		// Add a new if there isn't one
 		if (0 == m_params.count(_num))
 			m_params[_num] = new param_impl(stmt_h, _num);
@@ -99,10 +99,9 @@ YBORM_DECL ElementTree::ElementPtr
 xmlize_row(const Row &row, const String &entry_name)
 {
     ElementTree::ElementPtr entry = ElementTree::new_element(entry_name);
-    Row::const_iterator it = row.begin(), end = row.end();
-    for (; it != end; ++it)
-        entry->sub_element(mk_xml_name(it->first, _T("")),
-                it->second.nvl(Value(String(_T("")))).as_string());
+    for (size_t i = 0; i < row.size(); ++i)
+        entry->sub_element(mk_xml_name(row.name(i), _T("")),
+                row[i].nvl(Value(String(_T("")))).as_string());
     return entry;
 }
 
@@ -0,0 +1,95 @@
+// -*- Mode: C++; c-basic-offset: 4; tab-width: 4; indent-tabs-mode: nil; -*-
+#define YBUTIL_SOURCE
+
+#include <new>
+#include "util/object_pool.h"
+
+namespace Yb {
+
+ObjectPool::ObjectPool(size_t chunk_size)
+    : chunk_size_(chunk_size)
+    , used_(0)
+    , cur_(NULL)
+    , end_(NULL)
+{
+    for (int i = 0; i < N_CLASSES; ++i)
+        free_[i] = NULL;
+}
+
+ObjectPool::~ObjectPool()
+{
+    // live blocks hold a reference to the pool, so it can only get here
+    // with blocks in use if it was deleted by hand or lived on the stack;
+    // leave the chunks to the objects then, throwing is not an option
+    if (used_)
+        return;
+    std::vector<char *>::iterator i = chunks_.begin(), iend = chunks_.end();
+    for (; i != iend; ++i)
+        ::operator delete(*i);
+}
+
+void *
+ObjectPool::allocate(ObjectPool *pool, size_t size)
+{
+    if (pool && size <= MAX_BLOCK) {
+        size_t size_class = size? (size - 1) / GRANULE: 0;
+        return pool->take(size_class);
+    }
+    Block *block = (Block *)::operator new(sizeof(Block) + size);
+    block->header.pool = NULL;
+    block->header.size_class = 0;
+    return block + 1;
+}
+
+void
+ObjectPool::deallocate(void *p)
+{
+    if (!p)
+        return;
+    Block *block = (Block *)p - 1;
+    if (block->header.pool)
+        block->header.pool->put(block);
+    else
+        ::operator delete(block);
+}
+
+void *
+ObjectPool::take(size_t size_class)
+{
+    Block *block = free_[size_class];
+    if (block) {
+        free_[size_class] = *(Block **)(block + 1);
+    }
+    else {
+        size_t bytes = sizeof(Block) + (size_class + 1) * GRANULE;
+        if (cur_ + bytes > end_) {
+            size_t n = chunk_size_ > bytes? chunk_size_: bytes;
+            char *chunk = (char *)::operator new(n);
+            chunks_.push_back(chunk);
+            cur_ = chunk;
+            end_ = chunk + n;
+        }
+        block = (Block *)cur_;
+        cur_ += bytes;
+        block->header.pool = this;
+        block->header.size_class = size_class;
+    }
+    ++used_;
+    add_ref();
+    return block + 1;
+}
+
+void
+ObjectPool::put(Block *block)
+{
+    size_t size_class = block->header.size_class;
+    *(Block **)(block + 1) = free_[size_class];
+    free_[size_class] = block;
+    --used_;
+    // the last block of an abandoned pool frees all the chunks
+    release();
+}
+
+} // namespace Yb
+
+// vim:ts=4:sts=4:sw=4:et:
@@ -327,6 +327,10 @@ Value::as_decimal() const
 {
     if (type_ == DECIMAL)
         return get_as<Decimal>(bytes_);
+    if (type_ == INTEGER)
+        return Decimal(get_as<int>(bytes_));
+    if (type_ == LONGINT)
+        return Decimal((decimal_numerator)get_as<LongInt>(bytes_));
     String s = as_string();
     try {
         return Decimal(s);
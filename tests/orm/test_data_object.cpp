@@ -18,6 +18,8 @@ class TestDataObject : public CppUnit::TestFixture
     CPPUNIT_TEST(test_data_object_key);
     CPPUNIT_TEST(test_data_object_save_no_id);
     CPPUNIT_TEST(test_data_object_save_id);
+    CPPUNIT_TEST(test_identity_map);
+    CPPUNIT_TEST(test_change_lists);
     CPPUNIT_TEST_EXCEPTION(test_data_object_already_saved,
                            DataObjectAlreadyInSession);
     CPPUNIT_TEST(test_save_or_update);
@@ -33,6 +35,7 @@ class TestDataObject : public CppUnit::TestFixture
     CPPUNIT_TEST(test_traverse_down_up);
     CPPUNIT_TEST(test_traverse_up_down);
     CPPUNIT_TEST(test_calc_depth);
+    CPPUNIT_TEST(test_calc_table_depth);
     CPPUNIT_TEST_EXCEPTION(test_cycle_detected, CycleDetected);
     CPPUNIT_TEST(test_filter_by_key);
     //CPPUNIT_TEST(test_bad_type_cast_format);
@@ -148,6 +151,66 @@ public:
         CPPUNIT_ASSERT_EQUAL((int)DataObject::New, (int)d->status());
     }
 
+    void test_identity_map()
+    {
+        const Table &t = r_.table(_T("A"));
+        IdentityMap idmap;
+        ObjectList objs;
+        for (int i = 0; i < 1000; ++i) {
+            DataObject::Ptr d = DataObject::create_new(t);
+            d->set(_T("X"), i * 7);
+            objs.push_back(d);
+            CPPUNIT_ASSERT(!idmap.insert(d->object_key(), shptr_get(d)));
+        }
+        CPPUNIT_ASSERT_EQUAL((size_t)1000, idmap.size());
+        CPPUNIT_ASSERT(shptr_get(objs[5]) ==
+                idmap.insert(objs[5]->object_key(), shptr_get(objs[6])));
+        // probe with a row of the table, the value typed as the column
+        Values row(t.size());
+        row[0] = Value((LongInt)35);
+        CPPUNIT_ASSERT(shptr_get(objs[5]) == idmap.find(ObjectKey(t, &row[0])));
+        row[0] = Value((LongInt)36);
+        CPPUNIT_ASSERT(!idmap.find(ObjectKey(t, &row[0])));
+        for (int i = 0; i < 1000; i += 2)
+            CPPUNIT_ASSERT(idmap.erase(objs[i]->object_key()));
+        CPPUNIT_ASSERT(!idmap.erase(objs[0]->object_key()));
+        CPPUNIT_ASSERT_EQUAL((size_t)500, idmap.size());
+        for (int i = 0; i < 1000; ++i)
+            CPPUNIT_ASSERT(idmap.find(objs[i]->object_key()) ==
+                    (i % 2? shptr_get(objs[i]): NULL));
+        size_t count = 0;
+        IdentityMap::const_iterator j = idmap.begin(), jend = idmap.end();
+        for (; j != jend; ++j, ++count)
+            CPPUNIT_ASSERT((*j)->get(_T("X")).as_longint() % 2 == 1);
+        CPPUNIT_ASSERT_EQUAL((size_t)500, count);
+    }
+
+    void test_change_lists()
+    {
+        Session session(r_);
+        DataObject::Ptr d = DataObject::create_new(r_.table(_T("A")));
+        session.save(d);
+        DataObject::Ptr e = DataObject::create_new(r_.table(_T("A")),
+                                                   DataObject::Sync);
+        e->set(_T("X"), 20);
+        session.save(e);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, session.new_objs_.size());
+        CPPUNIT_ASSERT(session.dirty_objs_.empty());
+        e->set(_T("Y"), String(_T("abc")));
+        e->set(_T("Y"), String(_T("xyz")));
+        CPPUNIT_ASSERT_EQUAL((size_t)1, session.dirty_objs_.size());
+        e->delete_object(DelUnchecked);
+        CPPUNIT_ASSERT(session.dirty_objs_.empty());
+        CPPUNIT_ASSERT_EQUAL((size_t)1, session.to_delete_objs_.size());
+        d->delete_object(DelUnchecked);
+        CPPUNIT_ASSERT(session.new_objs_.empty());
+        CPPUNIT_ASSERT_EQUAL((size_t)1, session.deleted_objs_.size());
+        session.detach(e);
+        CPPUNIT_ASSERT(session.to_delete_objs_.empty());
+        session.clear();
+        CPPUNIT_ASSERT(session.deleted_objs_.empty());
+    }
+
     void test_data_object_already_saved()
     {
         DataObject::Ptr d = DataObject::create_new(r_.table(_T("A")));
@@ -317,6 +380,34 @@ public:
         CPPUNIT_ASSERT_EQUAL(2, f->depth());
     }
 
+    void test_calc_table_depth()
+    {
+        const Table &t = r_.table(_T("A"));
+        CPPUNIT_ASSERT(t.self_ref());
+        CPPUNIT_ASSERT(!r_.table(_T("B")).self_ref());
+        CPPUNIT_ASSERT(t.get_depth() < r_.table(_T("B")).get_depth());
+        DataObject::Ptr d = DataObject::create_new(t),
+            e = DataObject::create_new(t),
+            f = DataObject::create_new(t),
+            g = DataObject::create_new(r_.table(_T("B")));
+        DataObject::link_slave_to_master(f, e, _T("ParA"));
+        DataObject::link_slave_to_master(e, d, _T("ParA"));
+        DataObject::link_slave_to_master(g, f, _T("MasterA"));
+        int g_depth = g->depth();
+        DataObject::TableDepths depths;
+        f->calc_table_depth(0, 3, depths);
+        e->calc_table_depth(0, 3, depths);
+        d->calc_table_depth(0, 3, depths);
+        CPPUNIT_ASSERT_EQUAL(0, depths[shptr_get(d)]);
+        CPPUNIT_ASSERT_EQUAL(1, depths[shptr_get(e)]);
+        CPPUNIT_ASSERT_EQUAL(2, depths[shptr_get(f)]);
+        // objects of the other tables are not visited
+        CPPUNIT_ASSERT(depths.find(shptr_get(g)) == depths.end());
+        // the depths used by flush_delete() are not touched
+        CPPUNIT_ASSERT_EQUAL(g_depth, g->depth());
+        CPPUNIT_ASSERT_EQUAL(2, f->depth());
+    }
+
     void test_cycle_detected()
     {
         DataObject::Ptr d = DataObject::create_new(r_.table(_T("A"))),
@@ -395,9 +486,21 @@ class TestDataObjectSaveLoad : public CppUnit::TestFixture
     //CPPUNIT_TEST_EXCEPTION(test_lazy_load_fail, ObjectNotFoundByKey);
     CPPUNIT_TEST(test_lazy_load_fail);
     CPPUNIT_TEST(test_lazy_load_slaves);
+    CPPUNIT_TEST(test_lazy_load_slaves_batch);
+    CPPUNIT_TEST(test_incomplete_list);
+    CPPUNIT_TEST(test_load_from_identity_map);
+    CPPUNIT_TEST(test_object_pool);
+    CPPUNIT_TEST(test_stateless);
+    CPPUNIT_TEST(test_get_many);
+    CPPUNIT_TEST(test_ghost_batch);
+    CPPUNIT_TEST(test_ghost_list);
     CPPUNIT_TEST(test_flush_dirty);
+    CPPUNIT_TEST(test_flush_dirty_columns);
     CPPUNIT_TEST(test_flush_new);
     CPPUNIT_TEST(test_flush_new_with_id);
+    CPPUNIT_TEST(test_flush_new_wo_fill_fkeys);
+    CPPUNIT_TEST(test_flush_upsert);
+    CPPUNIT_TEST_EXCEPTION(test_upsert_wo_key, NullPK);
     CPPUNIT_TEST(test_flush_new_linked);
     CPPUNIT_TEST(test_flush_new_linked_to_existing);
     CPPUNIT_TEST(test_flush_deleted);
@@ -468,7 +571,7 @@ public:
 "    </table>"
 "    <relation type='one-to-many'>"
 "        <one class='OrmTest' />"
-"        <many class='OrmXml' property='orm_test' />"
+"        <many class='OrmXml' property='orm_test' batch-size='10' />"
 "    </relation>"
 "</schema>";
         MetaDataConfig cfg(xml);
@@ -553,6 +656,231 @@ public:
         CPPUNIT_ASSERT_EQUAL((int)RelationObject::Sync, (int)ro->status());
     }
 
+    void test_lazy_load_slaves_batch()
+    {
+        {
+            SqlConnection conn(Engine::sql_source_from_env());
+            conn.set_convert_params(true);
+            setup_log(conn);
+            conn.begin_trans_if_necessary();
+            conn.prepare(_T("INSERT INTO T_ORM_TEST(ID, A, B, C, D) VALUES(?, ?, ?, ?, ?)"));
+            Values params(5);
+            params[0] = Value(-11);
+            params[1] = Value(_T("other"));
+            params[2] = Value(now());
+            params[3] = Value(Decimal(_T("0.5")));
+            params[4] = Value(1.5);
+            conn.exec(params);
+            conn.prepare(_T("INSERT INTO T_ORM_XML(ID, ORM_TEST_ID, B) VALUES (?, ?, ?)"));
+            Values params2(3);
+            params2[0] = Value(-40);
+            params2[1] = Value(-11);
+            params2[2] = Value(Decimal(_T("1.1")));
+            conn.exec(params2);
+            conn.commit();
+        }
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        Session session(r_, &engine);
+        const Table &t = r_.table(_T("T_ORM_TEST"));
+        CPPUNIT_ASSERT_EQUAL(10, r_.find_relation(_T("OrmTest"))->batch_size());
+        DataObject::Ptr d1 = session.get_lazy(t.mk_key(-10)),
+            d2 = session.get_lazy(t.mk_key(-11));
+        RelationObject *ro1 = d1->get_slaves(), *ro2 = d2->get_slaves();
+        CPPUNIT_ASSERT_EQUAL((int)RelationObject::Incomplete, (int)ro2->status());
+        ro1->lazy_load_slaves();
+        // the other master's slaves come with the same query
+        CPPUNIT_ASSERT_EQUAL((int)RelationObject::Sync, (int)ro1->status());
+        CPPUNIT_ASSERT_EQUAL((int)RelationObject::Sync, (int)ro2->status());
+        CPPUNIT_ASSERT_EQUAL((size_t)2, ro1->slave_objects().size());
+        CPPUNIT_ASSERT_EQUAL((size_t)1, ro2->slave_objects().size());
+        CPPUNIT_ASSERT_EQUAL((LongInt)-40,
+                ro2->slave_objects()[0]->get(_T("ID")).as_longint());
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Ghost, (int)d2->status());
+    }
+
+    void test_incomplete_list()
+    {
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        Session session(r_, &engine);
+        const Table &t = r_.table(_T("T_ORM_TEST"));
+        const Relation *r = r_.find_relation(_T("OrmTest"));
+        DataObject::Ptr d1 = session.get_lazy(t.mk_key(-10)),
+            d2 = session.get_lazy(t.mk_key(-11)),
+            d3 = session.get_lazy(t.mk_key(-12));
+        RelationObject *ro1 = d1->get_slaves(), *ro2 = d2->get_slaves(),
+            *ro3 = d3->get_slaves();
+        IncompleteList &incomplete = *session.incomplete_objs_[r];
+        CPPUNIT_ASSERT_EQUAL((size_t)3, incomplete.size());
+        CPPUNIT_ASSERT(ro1 == incomplete.head());
+        // a detached master takes its relation objects along
+        session.detach(d3);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, incomplete.size());
+        ro2->lazy_load_slaves();
+        CPPUNIT_ASSERT_EQUAL((int)RelationObject::Sync, (int)ro1->status());
+        CPPUNIT_ASSERT_EQUAL((size_t)2, ro1->slave_objects().size());
+        CPPUNIT_ASSERT_EQUAL((int)RelationObject::Incomplete,
+                (int)ro3->status());
+        CPPUNIT_ASSERT(incomplete.empty());
+    }
+
+    void test_object_pool()
+    {
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        ObjectList objs;
+        ObjectPool *pool = new ObjectPool();
+        {
+            Session session(r_, &engine);
+            session.set_object_pool(pool);
+            session.load_collection(objs, Expression(_T("T_ORM_TEST")),
+                                    Expression());
+            CPPUNIT_ASSERT_EQUAL((size_t)1, objs.size());
+            CPPUNIT_ASSERT_EQUAL((size_t)1, pool->used());
+            session.clear();
+            CPPUNIT_ASSERT(pool != session.object_pool());
+        }
+        // the object has left the session, but its memory is still there
+        CPPUNIT_ASSERT_EQUAL((size_t)1, pool->used());
+        CPPUNIT_ASSERT_EQUAL(string("item"),
+                NARROW(objs[0]->get(_T("A")).as_string()));
+        objs.clear();
+    }
+
+    void test_stateless()
+    {
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        Session session(r_, &engine);
+        session.set_stateless(true);
+        ObjectList objs;
+        session.load_collection(objs, Expression(_T("T_ORM_TEST")),
+                                Expression());
+        session.load_collection(objs, Expression(_T("T_ORM_TEST")),
+                                Expression());
+        CPPUNIT_ASSERT_EQUAL((size_t)2, objs.size());
+        CPPUNIT_ASSERT(shptr_get(objs[0]) != shptr_get(objs[1]));
+        CPPUNIT_ASSERT(objs[0]->read_only());
+        CPPUNIT_ASSERT_EQUAL((Session *)NULL, objs[0]->session());
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Sync, (int)objs[0]->status());
+        CPPUNIT_ASSERT_EQUAL(string("item"),
+                NARROW(objs[0]->get(_T("A")).as_string()));
+        CPPUNIT_ASSERT_EQUAL((size_t)0, session.identity_map_.size());
+        CPPUNIT_ASSERT(session.objects_.empty());
+        bool thrown = false;
+        try {
+            objs[0]->set(_T("A"), Value(_T("xyz")));
+        }
+        catch (const ReadOnlyObject &) {
+            thrown = true;
+        }
+        CPPUNIT_ASSERT(thrown);
+        thrown = false;
+        try {
+            session.save(objs[1]);
+        }
+        catch (const ReadOnlyObject &) {
+            thrown = true;
+        }
+        CPPUNIT_ASSERT(thrown);
+    }
+
+    void test_load_from_identity_map()
+    {
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        Session session(r_, &engine);
+        DataObject::Ptr d = session.get_lazy
+            (r_.table(_T("T_ORM_TEST")).mk_key(-10));
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Ghost, (int)d->status());
+        ObjectList objs;
+        session.load_collection(objs, Expression(_T("T_ORM_TEST")),
+                                Expression());
+        CPPUNIT_ASSERT_EQUAL((size_t)1, objs.size());
+        CPPUNIT_ASSERT(shptr_get(d) == shptr_get(objs[0]));
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Sync, (int)d->status());
+        CPPUNIT_ASSERT_EQUAL(string("item"), NARROW(d->get(_T("A")).as_string()));
+        d->set(_T("A"), Value(_T("xyz")));
+        session.set_refresh_loaded(false);
+        objs.clear();
+        session.load_collection(objs, Expression(_T("T_ORM_TEST")),
+                                Expression());
+        CPPUNIT_ASSERT(shptr_get(d) == shptr_get(objs[0]));
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Dirty, (int)d->status());
+        CPPUNIT_ASSERT_EQUAL(string("xyz"), NARROW(d->get(_T("A")).as_string()));
+        session.set_refresh_loaded(true);
+        objs.clear();
+        session.load_collection(objs, Expression(_T("T_ORM_TEST")),
+                                Expression());
+        CPPUNIT_ASSERT(shptr_get(d) == shptr_get(objs[0]));
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Sync, (int)d->status());
+        CPPUNIT_ASSERT_EQUAL(string("item"), NARROW(d->get(_T("A")).as_string()));
+    }
+
+    void test_get_many()
+    {
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        Session session(r_, &engine);
+        const Table &t = r_.table(_T("T_ORM_XML"));
+        Keys keys;
+        keys.push_back(t.mk_key(-30));
+        keys.push_back(t.mk_key(-50));
+        keys.push_back(t.mk_key(-20));
+        ObjectList objs = session.get_many(keys);
+        CPPUNIT_ASSERT_EQUAL((size_t)3, objs.size());
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Sync, (int)objs[0]->status());
+        CPPUNIT_ASSERT(Decimal(_T("2.7")) == objs[0]->get(_T("B")).as_decimal());
+        // not found
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Ghost, (int)objs[1]->status());
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Sync, (int)objs[2]->status());
+        CPPUNIT_ASSERT(Decimal(_T("3.14")) == objs[2]->get(_T("B")).as_decimal());
+        CPPUNIT_ASSERT(shptr_get(objs[2]) ==
+                shptr_get(session.get_lazy(t.mk_key(-20))));
+    }
+
+    void test_ghost_batch()
+    {
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        Session session(r_, &engine);
+        session.set_ghost_batch(10);
+        const Table &t = r_.table(_T("T_ORM_XML"));
+        DataObject::Ptr e1 = session.get_lazy(t.mk_key(-20)),
+            e2 = session.get_lazy(t.mk_key(-30));
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Ghost, (int)e2->status());
+        CPPUNIT_ASSERT(Decimal(_T("3.14")) == e1->get(_T("B")).as_decimal());
+        // loaded along with the first one
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Sync, (int)e2->status());
+        CPPUNIT_ASSERT(Decimal(_T("2.7")) == e2->get(_T("B")).as_decimal());
+    }
+
+    void test_ghost_list()
+    {
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        Session session(r_, &engine);
+        session.set_ghost_batch(2);
+        const Table &t = r_.table(_T("T_ORM_XML"));
+        DataObject::Ptr e1 = session.get_lazy(t.mk_key(-50)),
+            e2 = session.get_lazy(t.mk_key(-30)),
+            e3 = session.get_lazy(t.mk_key(-20)),
+            d = session.get_lazy(r_.table(_T("T_ORM_TEST")).mk_key(-10));
+        ChangeList &ghosts = *session.ghost_objs_[&t];
+        CPPUNIT_ASSERT_EQUAL((size_t)3, ghosts.size());
+        CPPUNIT_ASSERT(shptr_get(e1) == ghosts.head());
+        // the Ghosts go in the batch in the order they were made
+        CPPUNIT_ASSERT(Decimal(_T("2.7")) == e2->get(_T("B")).as_decimal());
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Ghost, (int)e1->status());
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Ghost, (int)e3->status());
+        CPPUNIT_ASSERT_EQUAL((size_t)2, ghosts.size());
+        session.detach(e1);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, ghosts.size());
+        CPPUNIT_ASSERT(shptr_get(e3) == ghosts.head());
+        CPPUNIT_ASSERT_EQUAL((int)DataObject::Ghost, (int)d->status());
+    }
+
     void test_flush_dirty()
     {
         {
@@ -577,6 +905,38 @@ public:
         }
     }
 
+    void test_flush_dirty_columns()
+    {
+        {
+            Engine engine;
+            setup_log(engine);
+            Session session(r_, &engine);
+            const Table &t = r_.table(_T("T_ORM_TEST"));
+            DataObject::Ptr d = session.get_lazy(t.mk_key(-10));
+            CPPUNIT_ASSERT_EQUAL(string("item"), NARROW(d->get(_T("A")).as_string()));
+            CPPUNIT_ASSERT(d->changed_columns().empty());
+            d->set(_T("A"), Value(_T("xyz")));
+            CPPUNIT_ASSERT_EQUAL(t.size(), d->changed_columns().size());
+            CPPUNIT_ASSERT(d->changed_columns()[t.idx_by_name(_T("A"))]);
+            CPPUNIT_ASSERT(!d->changed_columns()[t.idx_by_name(_T("C"))]);
+            // column C is changed behind the session's back,
+            // the flush must not overwrite it
+            engine.touch();
+            engine.exec_proc(_T("UPDATE T_ORM_TEST SET C = 7 WHERE ID = -10"));
+            session.flush();
+            CPPUNIT_ASSERT(d->changed_columns().empty());
+            engine.commit();
+        }
+        {
+            Engine engine;
+            setup_log(engine);
+            Session session(r_, &engine);
+            DataObject::Ptr d = session.get_lazy(r_.table(_T("T_ORM_TEST")).mk_key(-10));
+            CPPUNIT_ASSERT_EQUAL(string("xyz"), NARROW(d->get(_T("A")).as_string()));
+            CPPUNIT_ASSERT(Decimal(7) == d->get(_T("C")).as_decimal());
+        }
+    }
+
     void test_flush_new()
     {
         Key k;
@@ -632,6 +992,94 @@ public:
         }
     }
 
+    void test_flush_new_wo_fill_fkeys()
+    {
+        // the tables of a hand-built schema have no depths filled
+        Table::Ptr t1(new Table(_T("T_ORM_TEST")));
+        *t1 << Column(_T("ID"), Value::LONGINT, 0, Column::PK)
+            << Column(_T("A"), Value::STRING, 200, 0);
+        Table::Ptr t2(new Table(_T("T_ORM_XML")));
+        *t2 << Column(_T("ID"), Value::LONGINT, 0, Column::PK)
+            << Column(_T("ORM_TEST_ID"), Value::LONGINT, 0, 0,
+                    Value(), _T("T_ORM_TEST"), _T("ID"));
+        Schema r;
+        r << t1 << t2;
+        CPPUNIT_ASSERT(!r.depths_filled());
+        {
+            Engine engine;
+            setup_log(engine);
+            Session session(r, &engine);
+            DataObject::Ptr e = DataObject::create_new(*t2);
+            e->set(_T("ID"), Value(9002));
+            e->set(_T("ORM_TEST_ID"), Value(9001));
+            session.save(e);
+            DataObject::Ptr d = DataObject::create_new(*t1);
+            d->set(_T("ID"), Value(9001));
+            d->set(_T("A"), Value(_T("master")));
+            session.save(d);
+            session.flush();
+            engine.commit();
+        }
+        SqlConnection conn(Engine::sql_source_from_env());
+        conn.prepare(_T("SELECT ID FROM T_ORM_TEST WHERE ID >= 9001"));
+        conn.exec(Values());
+        RowsPtr rows = conn.fetch_rows();
+        CPPUNIT_ASSERT_EQUAL(1, (int)rows->size());
+        CPPUNIT_ASSERT_EQUAL((LongInt)9001, (*rows)[0][0].as_longint());
+        conn.prepare(
+                _T("SELECT ID, ORM_TEST_ID FROM T_ORM_XML WHERE ID >= 9001"));
+        conn.exec(Values());
+        rows = conn.fetch_rows();
+        CPPUNIT_ASSERT_EQUAL(1, (int)rows->size());
+        CPPUNIT_ASSERT_EQUAL((LongInt)9002, (*rows)[0][0].as_longint());
+    }
+
+    void test_flush_upsert()
+    {
+        {
+            Engine engine;
+            setup_log(engine);
+            if (str_empty(engine.get_dialect()->sql_upsert(_T("T"),
+                        Strings(1, _T("ID")), Strings(1, _T("ID")),
+                        std::vector<Strings>(1, Strings(1, _T("?"))))))
+                return;
+            Session session(r_, &engine);
+            const Table &t = r_.table(_T("T_ORM_TEST"));
+            DataObject::Ptr d = DataObject::create_new(t);
+            d->set(_T("ID"), Value(-10));
+            d->set(_T("A"), Value(_T("upserted")));
+            session.save_or_update(d, true);
+            DataObject::Ptr e = DataObject::create_new(t);
+            e->set(_T("ID"), Value(-50));
+            e->set(_T("A"), Value(_T("inserted")));
+            session.save_or_update(e, true);
+            CPPUNIT_ASSERT(d->upsert() && e->upsert());
+            session.flush();
+            CPPUNIT_ASSERT(!d->upsert());
+            engine.commit();
+        }
+        {
+            Engine engine(Engine::READ_ONLY);
+            setup_log(engine);
+            Session session(r_, &engine);
+            const Table &t = r_.table(_T("T_ORM_TEST"));
+            CPPUNIT_ASSERT_EQUAL(string("upserted"), NARROW(session.get_lazy(
+                            t.mk_key(-10))->get(_T("A")).as_string()));
+            CPPUNIT_ASSERT_EQUAL(string("inserted"), NARROW(session.get_lazy(
+                            t.mk_key(-50))->get(_T("A")).as_string()));
+        }
+    }
+
+    void test_upsert_wo_key()
+    {
+        Engine engine;
+        setup_log(engine);
+        Session session(r_, &engine);
+        DataObject::Ptr d = DataObject::create_new(r_.table(_T("T_ORM_TEST")));
+        d->set(_T("A"), Value(_T("no key")));
+        session.save_or_update(d, true);
+    }
+
     void test_flush_new_linked()
     {
         Key k;
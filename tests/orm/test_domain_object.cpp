@@ -73,6 +73,8 @@ class TestDomainObject : public CppUnit::TestFixture
     CPPUNIT_TEST(test_null_fk_relation);
     CPPUNIT_TEST(test_holder);
     CPPUNIT_TEST(test_link_one2many);
+    CPPUNIT_TEST(test_eager_select_in);
+    CPPUNIT_TEST(test_eager_joined);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -220,6 +222,57 @@ public:
         ox3.orm_test = OrmTest::Holder(ot);
         CPPUNIT_ASSERT_EQUAL(3, (int)ot.orm_xmls.size());
     }
+
+    void check_eager(int mode)
+    {
+        {
+            SqlConnection conn(Engine::sql_source_from_env());
+            conn.set_convert_params(true);
+            setup_log(conn);
+            conn.begin_trans_if_necessary();
+            conn.prepare(_T("INSERT INTO T_ORM_TEST(ID, A) VALUES(?, ?)"));
+            Values params(2);
+            params[0] = Value(-11);
+            params[1] = Value(_T("one"));
+            conn.exec(params);
+            params[0] = Value(-12);
+            params[1] = Value(_T("none"));
+            conn.exec(params);
+            conn.prepare(_T("INSERT INTO T_ORM_XML(ID, ORM_TEST_ID, B) VALUES (?, ?, ?)"));
+            Values params2(3);
+            params2[0] = Value(-50);
+            params2[1] = Value(-11);
+            params2[2] = Value(Decimal(_T("5")));
+            conn.exec(params2);
+            conn.commit();
+        }
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        Session session(Yb::theSchema(), &engine);
+        DomainResultSet<OrmTest> rs = query<OrmTest>(session)
+            .eager<OrmXml>(mode)
+            .order_by(Expression(_T("T_ORM_TEST.ID"))).all();
+        vector<LongInt> ids;
+        vector<size_t> counts;
+        DomainResultSet<OrmTest>::iterator i = rs.begin(), iend = rs.end();
+        for (; i != iend; ++i) {
+            RelationObject *ro = i->get_data_object()->get_slaves();
+            CPPUNIT_ASSERT_EQUAL((int)RelationObject::Sync, (int)ro->status());
+            ids.push_back(i->get_data_object()->get(_T("ID")).as_longint());
+            counts.push_back(ro->slave_objects().size());
+        }
+        CPPUNIT_ASSERT_EQUAL((size_t)3, ids.size());
+        CPPUNIT_ASSERT_EQUAL((LongInt)-12, ids[0]);
+        CPPUNIT_ASSERT_EQUAL((size_t)0, counts[0]);
+        CPPUNIT_ASSERT_EQUAL((LongInt)-11, ids[1]);
+        CPPUNIT_ASSERT_EQUAL((size_t)1, counts[1]);
+        CPPUNIT_ASSERT_EQUAL((LongInt)-10, ids[2]);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, counts[2]);
+    }
+
+    void test_eager_select_in() { check_eager(EagerSelectIn); }
+
+    void test_eager_joined() { check_eager(EagerJoined); }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestDomainObject);
@@ -7,16 +7,37 @@
 using namespace std;
 using namespace Yb;
 
-Row::iterator find_in_row(Row &row, const String &name)
+Value &find_in_row(Row &row, const String &name)
 {
-    Row::iterator i = row.begin(), iend = row.end();
-    String uname = Yb::StrUtils::str_to_upper(name);
-    for (; i != iend; ++i)
-        if (i->first == uname)
-            break;
-    return i;
+    return row.get(name);
 }
 
+class StubIdAllocator: public HiLoIdAllocator
+{
+    LongInt value_;
+    LongInt reserve_block(EngineBase &engine, const String &seq_name)
+    {
+        ++calls_;
+        value_ += block_mode() == INCREMENT_BY? block_size(): 1;
+        LongInt value = value_;
+        // another thread gets an id while this one waits for the sequence
+        if (nested_) {
+            --nested_;
+            nested_ids_.push_back(next_id(engine, seq_name));
+        }
+        return value;
+    }
+public:
+    int calls_, nested_;
+    std::vector<LongInt> nested_ids_;
+    StubIdAllocator(int block_size, int block_mode)
+        : HiLoIdAllocator(block_size, block_mode)
+        , value_(0)
+        , calls_(0)
+        , nested_(0)
+    {}
+};
+
 class TestEngine : public CppUnit::TestFixture
 {
     CPPUNIT_TEST_SUITE(TestEngine);
@@ -36,10 +57,21 @@ class TestEngine : public CppUnit::TestFixture
     CPPUNIT_TEST_EXCEPTION(test_select_having_wo_groupby, BadSQLOperation);
     CPPUNIT_TEST(test_insert_simple);
     CPPUNIT_TEST(test_insert_exclude);
+    CPPUNIT_TEST(test_insert_batch);
+    CPPUNIT_TEST(test_insert_batch_numbered);
+    CPPUNIT_TEST(test_id_allocator_hilo);
+    CPPUNIT_TEST(test_id_allocator_increment_by);
+    CPPUNIT_TEST(test_id_allocator_concurrent);
+    CPPUNIT_TEST(test_id_allocator_options);
     CPPUNIT_TEST(test_update_where);
     CPPUNIT_TEST(test_update_combo);
+    CPPUNIT_TEST(test_update_columns);
+    CPPUNIT_TEST(test_dml_plans);
     CPPUNIT_TEST_EXCEPTION(test_update_wo_clause, BadSQLOperation);
     CPPUNIT_TEST(test_delete);
+    CPPUNIT_TEST(test_delete_batch);
+    CPPUNIT_TEST(test_upsert);
+    CPPUNIT_TEST_EXCEPTION(test_upsert_unsupported, BadSQLOperation);
     CPPUNIT_TEST_EXCEPTION(test_delete_wo_pk, BadSQLOperation);
     CPPUNIT_TEST_EXCEPTION(test_insert_ro_mode, BadOperationInMode);
     CPPUNIT_TEST_EXCEPTION(test_update_ro_mode, BadOperationInMode);
@@ -245,6 +277,98 @@ public:
         CPPUNIT_ASSERT_EQUAL((int)Value::LONGINT, types[0]);
     }
 
+    void test_insert_batch()
+    {
+        Engine engine(Engine::READ_ONLY);
+        Table t(_T("T"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        t.add_column(Column(_T("A"), Value::STRING, 0, 0));
+        String sql;
+        TypeCodes types;
+        ParamNums param_nums;
+        engine.gen_sql_insert(sql, types, param_nums, t, true, false, 3);
+        CPPUNIT_ASSERT_EQUAL(string("INSERT INTO T (ID, A) VALUES "
+                    "(?, ?), (?, ?), (?, ?)"), NARROW(sql));
+        CPPUNIT_ASSERT_EQUAL(2, (int)types.size());
+        CPPUNIT_ASSERT_EQUAL(2, (int)param_nums.size());
+        CPPUNIT_ASSERT_EQUAL(0, (int)param_nums[_T("ID")]);
+        CPPUNIT_ASSERT_EQUAL(1, (int)param_nums[_T("A")]);
+    }
+
+    void test_insert_batch_numbered()
+    {
+        Engine engine(Engine::READ_ONLY);
+        Table t(_T("T"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        t.add_column(Column(_T("A"), Value::STRING, 0, 0));
+        String sql;
+        TypeCodes types;
+        ParamNums param_nums;
+        engine.gen_sql_insert(sql, types, param_nums, t, false, true, 2);
+        CPPUNIT_ASSERT_EQUAL(string("INSERT INTO T (A) VALUES "
+                    "(:1), (:2)"), NARROW(sql));
+        CPPUNIT_ASSERT_EQUAL(1, (int)types.size());
+    }
+
+    void test_id_allocator_hilo()
+    {
+        Engine engine(Engine::READ_ONLY);
+        StubIdAllocator ids(3, HiLoIdAllocator::HI_LO);
+        CPPUNIT_ASSERT_EQUAL((LongInt)3, ids.next_id(engine, _T("S1")));
+        CPPUNIT_ASSERT_EQUAL((LongInt)4, ids.next_id(engine, _T("S1")));
+        CPPUNIT_ASSERT_EQUAL((LongInt)5, ids.next_id(engine, _T("S1")));
+        CPPUNIT_ASSERT_EQUAL(1, ids.calls_);
+        CPPUNIT_ASSERT_EQUAL((LongInt)6, ids.next_id(engine, _T("S1")));
+        CPPUNIT_ASSERT_EQUAL(2, ids.calls_);
+        CPPUNIT_ASSERT_EQUAL((LongInt)9, ids.next_id(engine, _T("S2")));
+        CPPUNIT_ASSERT_EQUAL(3, ids.calls_);
+    }
+
+    void test_id_allocator_increment_by()
+    {
+        Engine engine(Engine::READ_ONLY);
+        StubIdAllocator ids(10, HiLoIdAllocator::INCREMENT_BY);
+        for (int i = 0; i < 10; ++i)
+            CPPUNIT_ASSERT_EQUAL((LongInt)(10 + i),
+                    ids.next_id(engine, _T("S1")));
+        CPPUNIT_ASSERT_EQUAL(1, ids.calls_);
+        CPPUNIT_ASSERT_EQUAL((LongInt)20, ids.next_id(engine, _T("S1")));
+        CPPUNIT_ASSERT_EQUAL(2, ids.calls_);
+    }
+
+    void test_id_allocator_concurrent()
+    {
+        Engine engine(Engine::READ_ONLY);
+        StubIdAllocator ids(3, HiLoIdAllocator::HI_LO);
+        ids.nested_ = 1;
+        // the nested call reserves block 2 and installs it first,
+        // block 1 reserved by the outer call is kept as a spare
+        CPPUNIT_ASSERT_EQUAL((LongInt)7, ids.next_id(engine, _T("S1")));
+        CPPUNIT_ASSERT_EQUAL(1, (int)ids.nested_ids_.size());
+        CPPUNIT_ASSERT_EQUAL((LongInt)6, ids.nested_ids_[0]);
+        CPPUNIT_ASSERT_EQUAL((LongInt)8, ids.next_id(engine, _T("S1")));
+        for (int i = 3; i < 6; ++i)
+            CPPUNIT_ASSERT_EQUAL((LongInt)i, ids.next_id(engine, _T("S1")));
+        CPPUNIT_ASSERT_EQUAL(2, ids.calls_);
+        CPPUNIT_ASSERT_EQUAL((LongInt)9, ids.next_id(engine, _T("S1")));
+        CPPUNIT_ASSERT_EQUAL(3, ids.calls_);
+    }
+
+    void test_id_allocator_options()
+    {
+        SqlSource source;
+        std::auto_ptr<IdAllocator> ids = new_id_allocator(source);
+        CPPUNIT_ASSERT(dynamic_cast<SequenceIdAllocator *>(ids.get()));
+        source[_T("id_block")] = _T("50");
+        source[_T("id_block_mode")] = _T("increment_by");
+        ids = new_id_allocator(source);
+        HiLoIdAllocator *hilo = dynamic_cast<HiLoIdAllocator *>(ids.get());
+        CPPUNIT_ASSERT(hilo != NULL);
+        CPPUNIT_ASSERT_EQUAL(50, hilo->block_size());
+        CPPUNIT_ASSERT_EQUAL((int)HiLoIdAllocator::INCREMENT_BY,
+                hilo->block_mode());
+    }
+
     void test_update_where()
     {
         Engine engine(Engine::READ_ONLY);
@@ -265,6 +389,64 @@ public:
         CPPUNIT_ASSERT_EQUAL((int)Value::LONGINT, types[1]);
     }
 
+    void test_update_columns()
+    {
+        Engine engine(Engine::READ_ONLY);
+        Table t(_T("T"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        t.add_column(Column(_T("A"), Value::INTEGER, 0, 0));
+        t.add_column(Column(_T("B"), Value::STRING, 0, 0));
+        t.add_column(Column(_T("C"), Value::DECIMAL, 0, 0));
+        String sql;
+        TypeCodes types;
+        ParamNums param_nums;
+        SqlGeneratorOptions options(NO_QUOTES, true, true);
+        ColumnMask columns(t.size());
+        columns[2] = true;
+        engine.gen_sql_update(sql, types, param_nums, t, options, &columns);
+        CPPUNIT_ASSERT_EQUAL(string("UPDATE T SET B = ? WHERE T.ID = ?"), NARROW(sql));
+        CPPUNIT_ASSERT_EQUAL((size_t)2, types.size());
+        CPPUNIT_ASSERT_EQUAL(0, param_nums[_T("B")]);
+        CPPUNIT_ASSERT_EQUAL(1, param_nums[_T("ID")]);
+        columns[2] = false;
+        engine.gen_sql_update(sql, types, param_nums, t, options, &columns);
+        CPPUNIT_ASSERT(str_empty(sql));
+        CPPUNIT_ASSERT_EQUAL((size_t)0, types.size());
+    }
+
+    void test_dml_plans()
+    {
+        Table t(_T("T"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        t.add_column(Column(_T("A"), Value::INTEGER, 0, Column::RO));
+        t.add_column(Column(_T("B"), Value::STRING, 0, 0));
+        const DmlPlan &ins = EngineBase::insert_plan(t, true, false, 2);
+        CPPUNIT_ASSERT_EQUAL(string("INSERT INTO T (ID, B) VALUES "
+                    "(?, ?), (?, ?)"), NARROW(ins.sql_));
+        CPPUNIT_ASSERT_EQUAL((size_t)4, ins.type_codes_.size());
+        CPPUNIT_ASSERT_EQUAL((int)Value::STRING, ins.type_codes_[3]);
+        CPPUNIT_ASSERT_EQUAL((size_t)4, ins.col_idx_.size());
+        CPPUNIT_ASSERT_EQUAL(0, ins.col_idx_[2]);
+        CPPUNIT_ASSERT_EQUAL(2, ins.col_idx_[3]);
+        CPPUNIT_ASSERT(&ins == &EngineBase::insert_plan(t, true, false, 2));
+        CPPUNIT_ASSERT(&ins != &EngineBase::insert_plan(t, true, true, 2));
+        DmlPlan tail;
+        EngineBase::build_insert_plan(tail, t, true, false, 3);
+        CPPUNIT_ASSERT_EQUAL((size_t)6, tail.col_idx_.size());
+        CPPUNIT_ASSERT(t.find_plan(_T("INSERT:1:0:3")) == NULL);
+        CPPUNIT_ASSERT(t.find_plan(_T("INSERT:1:0:2")) == &ins);
+        const DmlPlan &upd = EngineBase::update_plan(t, true, ColumnMask());
+        CPPUNIT_ASSERT_EQUAL(string("UPDATE T SET B = :1 WHERE T.ID = :2"),
+                NARROW(upd.sql_));
+        CPPUNIT_ASSERT_EQUAL((size_t)2, upd.col_idx_.size());
+        CPPUNIT_ASSERT_EQUAL(2, upd.col_idx_[0]);
+        CPPUNIT_ASSERT_EQUAL(0, upd.col_idx_[1]);
+        const DmlPlan &del = EngineBase::delete_plan(t, false);
+        CPPUNIT_ASSERT_EQUAL(string("DELETE FROM T WHERE T.ID = ?"),
+                NARROW(del.sql_));
+        CPPUNIT_ASSERT_EQUAL((size_t)1, del.col_idx_.size());
+    }
+
     void test_update_combo()
     {
         Engine engine(Engine::READ_ONLY);
@@ -322,6 +504,83 @@ public:
         CPPUNIT_ASSERT_EQUAL((int)Value::LONGINT, types[0]);
     }
 
+    void test_delete_batch()
+    {
+        Engine engine(Engine::READ_ONLY);
+        Table t(_T("T"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        String sql;
+        TypeCodes types;
+        SqlGeneratorOptions options(NO_QUOTES, true, true);
+        engine.gen_sql_delete(sql, types, t, options, 3);
+        CPPUNIT_ASSERT_EQUAL(string("DELETE FROM T WHERE T.ID IN (?, ?, ?)"),
+                NARROW(sql));
+        CPPUNIT_ASSERT_EQUAL((size_t)3, types.size());
+        Table u(_T("U"));
+        u.add_column(Column(_T("A"), Value::LONGINT, 0, Column::PK));
+        u.add_column(Column(_T("B"), Value::STRING, 0, Column::PK));
+        engine.gen_sql_delete(sql, types, u, options, 2, true);
+        CPPUNIT_ASSERT_EQUAL(string("DELETE FROM U WHERE (U.A, U.B) IN "
+                    "((?, ?), (?, ?))"), NARROW(sql));
+        CPPUNIT_ASSERT_EQUAL((size_t)4, types.size());
+        CPPUNIT_ASSERT_EQUAL((int)Value::STRING, types[3]);
+        engine.gen_sql_delete(sql, types, u, options, 2, false);
+        CPPUNIT_ASSERT_EQUAL(string("DELETE FROM U WHERE "
+                    "((U.A = ?) AND (U.B = ?)) OR ((U.A = ?) AND (U.B = ?))"),
+                NARROW(sql));
+        const DmlPlan &del = EngineBase::delete_plan(u, true, 2, true);
+        CPPUNIT_ASSERT_EQUAL(string("DELETE FROM U WHERE (U.A, U.B) IN "
+                    "((:1, :2), (:3, :4))"), NARROW(del.sql_));
+        CPPUNIT_ASSERT_EQUAL((size_t)4, del.col_idx_.size());
+        CPPUNIT_ASSERT_EQUAL(1, del.col_idx_[3]);
+    }
+
+    void test_upsert()
+    {
+        Table t(_T("T"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        t.add_column(Column(_T("A"), Value::STRING, 0, 0));
+        t.add_column(Column(_T("B"), Value::STRING, 0, Column::RO));
+        String sql;
+        TypeCodes types;
+        ParamNums param_nums;
+        EngineBase::gen_sql_upsert(sql, types, param_nums, t,
+                sql_dialect(_T("POSTGRES")), false, 2);
+        CPPUNIT_ASSERT_EQUAL(string("INSERT INTO T (ID, A) VALUES "
+                    "(?, ?), (?, ?) ON CONFLICT (ID) DO UPDATE "
+                    "SET A = excluded.A"), NARROW(sql));
+        CPPUNIT_ASSERT_EQUAL((size_t)2, types.size());
+        CPPUNIT_ASSERT_EQUAL(1, param_nums[_T("A")]);
+        EngineBase::gen_sql_upsert(sql, types, param_nums, t,
+                sql_dialect(_T("MYSQL")));
+        CPPUNIT_ASSERT_EQUAL(string("INSERT INTO T (ID, A) VALUES (?, ?) "
+                    "ON DUPLICATE KEY UPDATE A = VALUES(A)"), NARROW(sql));
+        EngineBase::gen_sql_upsert(sql, types, param_nums, t,
+                sql_dialect(_T("ORACLE")), true, 2);
+        CPPUNIT_ASSERT_EQUAL(string("MERGE INTO T USING ("
+                    "SELECT :1 ID, :2 A FROM DUAL UNION ALL "
+                    "SELECT :3 ID, :4 A FROM DUAL) S ON (T.ID = S.ID) "
+                    "WHEN MATCHED THEN UPDATE SET T.A = S.A "
+                    "WHEN NOT MATCHED THEN INSERT (ID, A) "
+                    "VALUES (S.ID, S.A)"), NARROW(sql));
+        const DmlPlan &plan = EngineBase::upsert_plan(t,
+                sql_dialect(_T("SQLITE")), false, 2);
+        CPPUNIT_ASSERT_EQUAL((size_t)4, plan.type_codes_.size());
+        CPPUNIT_ASSERT_EQUAL((size_t)4, plan.col_idx_.size());
+        CPPUNIT_ASSERT_EQUAL(1, plan.col_idx_[3]);
+    }
+
+    void test_upsert_unsupported()
+    {
+        Table t(_T("T"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        String sql;
+        TypeCodes types;
+        ParamNums param_nums;
+        EngineBase::gen_sql_upsert(sql, types, param_nums, t,
+                sql_dialect(_T("INTERBASE")), false, 2);
+    }
+
     void test_delete_wo_pk()
     {
         Engine engine(Engine::READ_ONLY);
@@ -400,7 +659,7 @@ static LongInt get_next_test_id(SqlConnection *conn)
     CPPUNIT_ASSERT(ptr.get() != NULL);
     RowPtr end = cur->fetch_row();
     CPPUNIT_ASSERT(end.get() == NULL);
-    Value x = find_in_row(*ptr, _T("MAX_ID"))->second;
+    Value x = find_in_row(*ptr, _T("MAX_ID"));
     return x.is_null()? 1: x.as_longint() + 1;
 }
 
@@ -409,8 +668,17 @@ class TestEngineSql : public CppUnit::TestFixture
     CPPUNIT_TEST_SUITE(TestEngineSql);
     CPPUNIT_TEST(test_select_sql);
     CPPUNIT_TEST(test_select_sql_max_rows);
+    CPPUNIT_TEST(test_select_sql_types);
+    CPPUNIT_TEST(test_select_sql_header);
     CPPUNIT_TEST(test_insert_sql);
+    CPPUNIT_TEST(test_insert_longint_sql);
+    CPPUNIT_TEST(test_insert_batch_sql);
+    CPPUNIT_TEST(test_insert_batch_ids_sql);
     CPPUNIT_TEST(test_update_sql);
+    CPPUNIT_TEST(test_stmt_cache_sql);
+    CPPUNIT_TEST(test_delete_batch_sql);
+    CPPUNIT_TEST(test_exec_many_sql);
+    CPPUNIT_TEST(test_fetch_block_sql);
     CPPUNIT_TEST_SUITE_END();
 
     LongInt record_id_;
@@ -456,9 +724,9 @@ public:
         CPPUNIT_ASSERT_EQUAL(true, engine.activity());
         CPPUNIT_ASSERT_EQUAL(1, (int)ptr->size());
         CPPUNIT_ASSERT_EQUAL(string("item"),
-                NARROW(find_in_row(*ptr->begin(), _T("A"))->second.as_string()));
+                NARROW(find_in_row(*ptr->begin(), _T("A")).as_string()));
         CPPUNIT_ASSERT(Decimal(_T("1.2")) ==
-                       find_in_row(*ptr->begin(), _T("C"))->second.as_decimal());
+                       find_in_row(*ptr->begin(), _T("C")).as_decimal());
     }
 
     void test_select_sql_max_rows()
@@ -474,6 +742,56 @@ public:
         CPPUNIT_ASSERT_EQUAL(0, (int)ptr->size());
     }
 
+    void test_select_sql_types()
+    {
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        if (engine.get_dialect()->get_name() != _T("SQLITE"))
+            return;
+        RowsPtr ptr = engine.select(Expression(_T("*")),
+                Expression(_T("T_ORM_TEST")),
+                Expression(_T("ID")) == record_id_);
+        CPPUNIT_ASSERT_EQUAL(1, (int)ptr->size());
+        Row &row = *ptr->begin();
+        CPPUNIT_ASSERT_EQUAL((int)Value::LONGINT,
+                find_in_row(row, _T("ID")).get_type());
+        CPPUNIT_ASSERT_EQUAL((int)Value::STRING,
+                find_in_row(row, _T("A")).get_type());
+        CPPUNIT_ASSERT_EQUAL((int)Value::DATETIME,
+                find_in_row(row, _T("B")).get_type());
+        CPPUNIT_ASSERT(dt_make(2001, 1, 1) ==
+                find_in_row(row, _T("B")).read_as_datetime());
+        CPPUNIT_ASSERT_EQUAL((int)Value::DECIMAL,
+                find_in_row(row, _T("C")).get_type());
+        CPPUNIT_ASSERT(Decimal(_T("1.2")) ==
+                find_in_row(row, _T("C")).read_as_decimal());
+        CPPUNIT_ASSERT(find_in_row(row, _T("D")).is_null());
+    }
+
+    void test_select_sql_header()
+    {
+        Engine engine(Engine::READ_WRITE);
+        setup_log(engine);
+        engine.get_conn()->exec_direct(
+                _T("INSERT INTO T_ORM_TEST(ID, A) VALUES(")
+                + to_string(record_id_ + 1) + _T(", 'next')"));
+        RowsPtr ptr = engine.select(Expression(_T("ID, A")),
+                Expression(_T("T_ORM_TEST")),
+                Expression(_T("ID")) >= record_id_,
+                Expression(), Expression(), Expression(_T("ID")));
+        CPPUNIT_ASSERT_EQUAL(2, (int)ptr->size());
+        const Row &r0 = (*ptr)[0], &r1 = (*ptr)[1];
+        CPPUNIT_ASSERT(shptr_get(r0.header()) == shptr_get(r1.header()));
+        CPPUNIT_ASSERT_EQUAL(2, (int)r0.header()->size());
+        CPPUNIT_ASSERT_EQUAL(string("ID"), NARROW(r0.name(0)));
+        CPPUNIT_ASSERT_EQUAL(1, r0.find(_T("A")));
+        CPPUNIT_ASSERT_EQUAL(1, r0.find(_T("a")));
+        CPPUNIT_ASSERT_EQUAL(-1, r0.find(_T("B")));
+        CPPUNIT_ASSERT_EQUAL(string("next"),
+                NARROW(r1.get(_T("A")).as_string()));
+        engine.commit();
+    }
+
     void test_insert_sql()
     {
         Engine engine(Engine::READ_WRITE);
@@ -499,9 +817,111 @@ public:
                 t.column(_T("ID")) == id);
         CPPUNIT_ASSERT_EQUAL(1, (int)ptr->size());
         CPPUNIT_ASSERT_EQUAL(string("inserted"),
-                NARROW(find_in_row(*ptr->begin(), _T("A"))->second.as_string()));
+                NARROW(find_in_row(*ptr->begin(), _T("A")).as_string()));
         CPPUNIT_ASSERT(Decimal(_T("1.1")) ==
-                find_in_row(*ptr->begin(), _T("C"))->second.as_decimal());
+                find_in_row(*ptr->begin(), _T("C")).as_decimal());
+        engine.commit();
+    }
+
+    void test_insert_longint_sql()
+    {
+        Engine engine(Engine::READ_WRITE);
+        Table t(_T("T_ORM_TEST"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        t.add_column(Column(_T("A"), Value::STRING, 100, 0));
+        t.add_column(Column(_T("D"), Value::FLOAT, 0, 0));
+        setup_log(engine);
+        LongInt id = (LongInt)3 * 1000 * 1000 * 1000 + record_id_;
+        RowsData rows;
+        Values row;
+        row.push_back(Value(id));
+        row.push_back(Value(_T("big")));
+        row.push_back(Value(2.5));
+        rows.push_back(&row);
+        engine.insert(t, rows, false);
+        RowsPtr ptr = engine.select(Expression(_T("*")),
+                Expression(t.name()),
+                t.column(_T("ID")) == id);
+        CPPUNIT_ASSERT_EQUAL(1, (int)ptr->size());
+        CPPUNIT_ASSERT(id ==
+                find_in_row(*ptr->begin(), _T("ID")).as_longint());
+        CPPUNIT_ASSERT_EQUAL(2.5,
+                find_in_row(*ptr->begin(), _T("D")).as_float());
+        engine.commit();
+    }
+
+    void test_insert_batch_sql()
+    {
+        Engine engine(Engine::READ_WRITE);
+        Table t(_T("T_ORM_TEST"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        t.add_column(Column(_T("A"), Value::STRING, 100, 0));
+        t.add_column(Column(_T("B"), Value::DATETIME, 0, Column::RO));
+        t.add_column(Column(_T("C"), Value::DECIMAL, 0, 0));
+        setup_log(engine);
+        engine.get_conn()->set_insert_batch(2);
+        LongInt id = get_next_test_id(engine.get_conn());
+        std::vector<Values> data(5);
+        RowsData rows;
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i].push_back(Value(id + (LongInt)i));
+            data[i].push_back(Value(_T("batch")));
+            data[i].push_back(Value());
+            data[i].push_back(Value(Decimal((int)i)));
+            rows.push_back(&data[i]);
+        }
+        engine.insert(t, rows, false);
+        RowsPtr ptr = engine.select(Expression(_T("*")),
+                Expression(t.name()),
+                t.column(_T("A")) == Value(_T("batch")),
+                Expression(), Expression(), Expression(_T("ID")));
+        CPPUNIT_ASSERT_EQUAL(5, (int)ptr->size());
+        for (size_t i = 0; i < data.size(); ++i) {
+            CPPUNIT_ASSERT_EQUAL(id + (LongInt)i,
+                    find_in_row((*ptr)[i], _T("ID")).as_longint());
+            CPPUNIT_ASSERT(Decimal((int)i) ==
+                    find_in_row((*ptr)[i], _T("C")).as_decimal());
+        }
+        engine.commit();
+    }
+
+    void test_insert_batch_ids_sql()
+    {
+        Engine engine(Engine::READ_WRITE);
+        if (engine.get_dialect()->has_sequences())
+            return;
+        Table t(_T("T_ORM_TEST"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        t.add_column(Column(_T("A"), Value::STRING, 100, 0));
+        t.add_column(Column(_T("B"), Value::DATETIME, 0, Column::RO));
+        t.add_column(Column(_T("C"), Value::DECIMAL, 0, 0));
+        setup_log(engine);
+        engine.get_conn()->set_insert_batch(2);
+        CPPUNIT_ASSERT(!engine.get_conn()->consecutive_ids());
+        std::vector<Values> data(3);
+        RowsData rows;
+        for (size_t i = 0; i < data.size(); ++i) {
+            data[i].push_back(Value());
+            data[i].push_back(Value(_T("ids")));
+            data[i].push_back(Value());
+            data[i].push_back(Value(Decimal((int)i)));
+            rows.push_back(&data[i]);
+        }
+        // the same ids are expected whether or not the batch is trusted
+        // to get a consecutive range
+        for (int consecutive = 0; consecutive < 2; ++consecutive) {
+            engine.get_conn()->set_consecutive_ids(consecutive != 0);
+            std::vector<LongInt> ids = engine.insert(t, rows, true);
+            CPPUNIT_ASSERT_EQUAL(3, (int)ids.size());
+            for (size_t i = 0; i < ids.size(); ++i) {
+                RowsPtr ptr = engine.select(Expression(_T("*")),
+                        Expression(t.name()),
+                        Expression(_T("ID")) == ids[i]);
+                CPPUNIT_ASSERT_EQUAL(1, (int)ptr->size());
+                CPPUNIT_ASSERT(Decimal((int)i) ==
+                        find_in_row((*ptr)[0], _T("C")).as_decimal());
+            }
+        }
         engine.commit();
     }
 
@@ -528,11 +948,137 @@ public:
                 Expression(_T("ID")) == record_id_);
         CPPUNIT_ASSERT_EQUAL(1, (int)ptr->size());
         CPPUNIT_ASSERT_EQUAL(string("updated"),
-                NARROW(find_in_row(*ptr->begin(), _T("A"))->second.as_string()));
+                NARROW(find_in_row(*ptr->begin(), _T("A")).as_string()));
         CPPUNIT_ASSERT(Decimal(_T("1.3")) ==
-                find_in_row(*ptr->begin(), _T("C"))->second.as_decimal());
+                find_in_row(*ptr->begin(), _T("C")).as_decimal());
         CPPUNIT_ASSERT(timestamp !=
-                find_in_row(*ptr->begin(), _T("B"))->second.as_date_time());
+                find_in_row(*ptr->begin(), _T("B")).as_date_time());
+        engine.commit();
+    }
+
+    void test_stmt_cache_sql()
+    {
+        Engine engine(Engine::READ_ONLY);
+        setup_log(engine);
+        SqlConnection *conn = engine.get_conn();
+        conn->set_stmt_cache_size(2);
+        for (int i = 0; i < 3; ++i) {
+            RowsPtr ptr = engine.select(Expression(_T("*")),
+                    Expression(_T("T_ORM_TEST")),
+                    Expression(_T("ID")) == record_id_);
+            CPPUNIT_ASSERT_EQUAL(1, (int)ptr->size());
+            CPPUNIT_ASSERT_EQUAL(1, (int)conn->stmt_cache_count());
+        }
+        engine.select(Expression(_T("A")), Expression(_T("T_ORM_TEST")),
+                Expression(_T("ID")) == record_id_);
+        engine.select(Expression(_T("B")), Expression(_T("T_ORM_TEST")),
+                Expression(_T("ID")) == record_id_);
+        CPPUNIT_ASSERT_EQUAL(2, (int)conn->stmt_cache_count());
+        conn->set_stmt_cache_size(1);
+        CPPUNIT_ASSERT_EQUAL(1, (int)conn->stmt_cache_count());
+        try {
+            conn->exec_direct(_T("SELECT * FROM NO_SUCH_TABLE"));
+            CPPUNIT_FAIL("DBError expected");
+        }
+        catch (const DBError &) {}
+        CPPUNIT_ASSERT(conn->bad());
+        CPPUNIT_ASSERT_EQUAL(0, (int)conn->stmt_cache_count());
+    }
+
+    void test_delete_batch_sql()
+    {
+        Engine engine(Engine::READ_WRITE);
+        Table t(_T("T_ORM_TEST"));
+        t.add_column(Column(_T("ID"), Value::LONGINT, 0, Column::PK));
+        t.add_column(Column(_T("A"), Value::STRING, 100, 0));
+        setup_log(engine);
+        engine.get_conn()->set_delete_batch(2);
+        Keys keys;
+        for (int i = 0; i < 3; ++i) {
+            LongInt id = get_next_test_id(engine.get_conn());
+            Values row;
+            row.push_back(id);
+            row.push_back(Value(_T("deleted")));
+            RowsData rows;
+            rows.push_back(&row);
+            engine.insert(t, rows, false);
+            Key key(t.name(), ValueMap());
+            key.second.push_back(make_pair(String(_T("ID")), Value(id)));
+            keys.push_back(key);
+        }
+        engine.delete_from(t, keys);
+        RowsPtr ptr = engine.select(Expression(_T("*")),
+                Expression(t.name()),
+                Expression(_T("A")) == Value(_T("deleted")));
+        CPPUNIT_ASSERT_EQUAL(0, (int)ptr->size());
+        engine.commit();
+    }
+
+    void test_exec_many_sql()
+    {
+        Engine engine(Engine::READ_WRITE);
+        setup_log(engine);
+        SqlConnection *conn = engine.get_conn();
+        std::vector<Values> params_list(3);
+        LongInt id = get_next_test_id(conn);
+        for (size_t i = 0; i < params_list.size(); ++i) {
+            params_list[i].push_back(Value(id + (LongInt)i));
+            params_list[i].push_back(Value(_T("many")));
+            params_list[i].push_back(i == 1? Value(): Value((int)i));
+        }
+        auto_ptr<SqlCursor> cursor = conn->new_cursor();
+        cursor->prepare(_T("INSERT INTO T_ORM_TEST(ID, A, D) VALUES(?, ?, ?)"));
+        cursor->exec_many(params_list);
+        RowsPtr ptr = engine.select(Expression(_T("*")),
+                Expression(_T("T_ORM_TEST")),
+                Expression(_T("A")) == Value(_T("many")));
+        CPPUNIT_ASSERT_EQUAL(3, (int)ptr->size());
+        engine.commit();
+    }
+
+    void test_fetch_block_sql()
+    {
+        Engine engine(Engine::READ_WRITE);
+        setup_log(engine);
+        SqlConnection *conn = engine.get_conn();
+        std::vector<Values> params_list(4);
+        for (size_t i = 0; i < params_list.size(); ++i) {
+            params_list[i].push_back(Value(record_id_ + 1 + (LongInt)i));
+            params_list[i].push_back(Value(_T("block")));
+        }
+        auto_ptr<SqlCursor> cursor = conn->new_cursor();
+        cursor->prepare(_T("INSERT INTO T_ORM_TEST(ID, A) VALUES(?, ?)"));
+        cursor->exec_many(params_list);
+        cursor->prepare(
+                _T("SELECT ID, A FROM T_ORM_TEST WHERE A = ? ORDER BY ID"));
+        Values params;
+        params.push_back(Value(_T("block")));
+        cursor->exec(params);
+        RowBlock block;
+        CPPUNIT_ASSERT_EQUAL(3, (int)cursor->fetch_block(block, 3));
+        CPPUNIT_ASSERT_EQUAL(3, (int)block.size());
+        CPPUNIT_ASSERT(record_id_ + 1 == block[0].get(_T("ID")).as_longint());
+        CPPUNIT_ASSERT(shptr_get(block[0].header()) ==
+                shptr_get(block[2].header()));
+        CPPUNIT_ASSERT_EQUAL(1, (int)cursor->fetch_block(block, 3));
+        CPPUNIT_ASSERT_EQUAL(1, (int)block.size());
+        CPPUNIT_ASSERT_EQUAL(3, (int)block.capacity());
+        CPPUNIT_ASSERT(record_id_ + 4 == block[0].get(_T("ID")).as_longint());
+        CPPUNIT_ASSERT_EQUAL(0, (int)cursor->fetch_block(block, 3));
+        SqlResultSet rs = cursor->exec(params);
+        rs.set_prefetch(3);
+        SqlResultSet rs_copy(rs);
+        CPPUNIT_ASSERT_EQUAL(3, (int)rs_copy.prefetch());
+        CPPUNIT_ASSERT(record_id_ + 1 ==
+                rs_copy.begin()->get(_T("ID")).as_longint());
+        conn->set_row_block(2);
+        RowsPtr ptr = engine.select(Expression(_T("*")),
+                Expression(_T("T_ORM_TEST")),
+                Expression(_T("A")) == Value(_T("block")),
+                Expression(), Expression(), Expression(_T("ID")), 3);
+        CPPUNIT_ASSERT_EQUAL(3, (int)ptr->size());
+        CPPUNIT_ASSERT(record_id_ + 3 ==
+                find_in_row((*ptr)[2], _T("ID")).as_longint());
         engine.commit();
     }
 };
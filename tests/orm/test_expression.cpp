@@ -15,6 +15,7 @@ class TestExpression : public CppUnit::TestFixture
     CPPUNIT_TEST(testOperatorAnd);
     CPPUNIT_TEST(testLike);
     CPPUNIT_TEST(testIn);
+    CPPUNIT_TEST(testFilterKeys);
     CPPUNIT_TEST(testCollectParams);
     CPPUNIT_TEST(testExprList);
 #if defined(YB_USE_TUPLE)
@@ -81,6 +82,24 @@ public:
 #endif // defined(YB_USE_STDTUPLE)
     }
 
+    void testFilterKeys()
+    {
+        Keys keys(2);
+        keys[0].first = keys[1].first = _T("A");
+        keys[0].second.push_back(make_pair(String(_T("X")), Value(1)));
+        keys[1].second.push_back(make_pair(String(_T("X")), Value(2)));
+        CPPUNIT_ASSERT_EQUAL(string("A.X IN (1, 2)"),
+                             NARROW(filter_keys(keys).get_sql()));
+        keys[0].second.push_back(make_pair(String(_T("Y")), Value(3)));
+        keys[1].second.push_back(make_pair(String(_T("Y")), Value(4)));
+        CPPUNIT_ASSERT_EQUAL(
+                string("((A.X = 1) AND (A.Y = 3)) OR ((A.X = 2) AND (A.Y = 4))"),
+                NARROW(filter_keys(keys).get_sql()));
+        keys.pop_back();
+        CPPUNIT_ASSERT_EQUAL(string("(A.X = 1) AND (A.Y = 3)"),
+                             NARROW(filter_keys(keys).get_sql()));
+    }
+
     void testCollectParams()
     {
         Expression expr = Expression(_T("ID")) == 1 &&
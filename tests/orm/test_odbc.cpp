@@ -0,0 +1,241 @@
+#if defined(YB_USE_ODBC)
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestAssert.h>
+#include "util/string_utils.h"
+#include "orm/sql_driver.h"
+#include "orm/engine.h"
+#include "tiodbc.h"
+
+using namespace std;
+using namespace Yb;
+
+// The tests use the ODBC data source named by YBORM_ODBC_DSN,
+// like test1_db_sqlite from tests/orm/odbc.ini, and do nothing
+// if it is not set.
+
+static SqlSource odbc_source(const String &dsn)
+{
+    return SqlSource(_T(""), _T("ODBC"), _T("SQLITE"), dsn);
+}
+
+class TestOdbcDriver : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestOdbcDriver);
+    CPPUNIT_TEST(test_execute_array);
+    CPPUNIT_TEST(test_exec_many);
+    CPPUNIT_TEST(test_fetch_array);
+    CPPUNIT_TEST(test_fetch_array_lob);
+    CPPUNIT_TEST(test_row_block);
+    CPPUNIT_TEST_SUITE_END();
+
+    String dsn_;
+
+    void insert_rows(SqlConnection &conn, int count)
+    {
+        std::vector<Values> params_list(count);
+        for (int i = 0; i < count; ++i) {
+            params_list[i].push_back(Value((LongInt)i + 1));
+            params_list[i].push_back(i == 1? Value(): Value(_T("row")));
+            params_list[i].push_back(Value(0.5 * i));
+            params_list[i].push_back(Value(String(300, _T('x'))));
+        }
+        auto_ptr<SqlCursor> cursor = conn.new_cursor();
+        cursor->prepare(
+                _T("INSERT INTO T_ODBC_TEST(ID, A, B, D) VALUES(?, ?, ?, ?)"));
+        cursor->exec_many(params_list);
+    }
+public:
+    void setUp()
+    {
+        dsn_ = env_cfg(_T("ODBC_DSN"));
+        if (str_empty(dsn_))
+            return;
+        SqlConnection conn(odbc_source(dsn_));
+        conn.begin_trans_if_necessary();
+        conn.exec_direct(_T("DROP TABLE IF EXISTS T_ODBC_TEST"));
+        conn.exec_direct(_T("CREATE TABLE T_ODBC_TEST(ID INTEGER PRIMARY KEY, ")
+                _T("A VARCHAR(20), B DOUBLE, C TIMESTAMP, D VARCHAR(4000))"));
+        conn.commit();
+    }
+
+    void test_execute_array()
+    {
+        if (str_empty(dsn_))
+            return;
+        tiodbc::connection conn;
+        CPPUNIT_ASSERT(conn.connect(dsn_, _T(""), _T("")));
+        tiodbc::statement stmt;
+        CPPUNIT_ASSERT(stmt.prepare(conn,
+                    _T("INSERT INTO T_ODBC_TEST(ID, A, B) VALUES(?, ?, ?)")));
+        const String names[] = { _T("a"), _T(""), _T("ccc") };
+        tiodbc::param_array arr(3);
+        for (int i = 0; i < 3; ++i) {
+            CPPUNIT_ASSERT(arr.set_as_long(1, i, i + 1));
+            if (i == 1)
+                arr.set_as_null(2, i);
+            else
+                CPPUNIT_ASSERT(arr.set_as_string(2, i, names[i]));
+            CPPUNIT_ASSERT(arr.set_as_double(3, i, 0.5 * i));
+        }
+        // the type of a parameter is fixed by its first value
+        CPPUNIT_ASSERT(!arr.set_as_long(3, 2, 1));
+        CPPUNIT_ASSERT(stmt.execute_array(arr));
+        // the statement is back to single parameter sets
+        SQLULEN paramset_size = 0;
+        SQLGetStmtAttr(stmt.native_stmt_handle(), SQL_ATTR_PARAMSET_SIZE,
+                &paramset_size, 0, NULL);
+        CPPUNIT_ASSERT_EQUAL(1, (int)paramset_size);
+        stmt.param(1).set_as_long(4);
+        stmt.param(2).set_as_string(_T("dddd"));
+        stmt.param(3).set_as_double(2.5);
+        CPPUNIT_ASSERT(stmt.execute());
+
+        CPPUNIT_ASSERT(stmt.execute_direct(conn,
+                    _T("SELECT ID, A, B FROM T_ODBC_TEST ORDER BY ID")));
+        for (int i = 0; i < 4; ++i) {
+            CPPUNIT_ASSERT(stmt.fetch_next());
+            CPPUNIT_ASSERT_EQUAL(i + 1, (int)stmt.field(1).as_long());
+            CPPUNIT_ASSERT_EQUAL(i == 1, (bool)stmt.field(2).is_null());
+            CPPUNIT_ASSERT_EQUAL(0.5 * i + (i == 3? 1: 0),
+                    stmt.field(3).as_double());
+        }
+        CPPUNIT_ASSERT(!stmt.fetch_next());
+    }
+
+    void test_exec_many()
+    {
+        if (str_empty(dsn_))
+            return;
+        SqlConnection conn(odbc_source(dsn_));
+        conn.begin_trans_if_necessary();
+        std::vector<Values> params_list(5);
+        for (size_t i = 0; i < params_list.size(); ++i) {
+            params_list[i].push_back(Value((LongInt)i + 1));
+            params_list[i].push_back(i == 2? Value(): Value(_T("many")));
+            params_list[i].push_back(Value(dt_make(2001, 1, i + 1)));
+        }
+        auto_ptr<SqlCursor> cursor = conn.new_cursor();
+        cursor->prepare(_T("INSERT INTO T_ODBC_TEST(ID, A, C) VALUES(?, ?, ?)"));
+        cursor->exec_many(params_list);
+        // a parameter changing its type makes the sets go one by one
+        std::vector<Values> mixed(2);
+        mixed[0].push_back(Value((LongInt)6));
+        mixed[0].push_back(Value(_T("six")));
+        mixed[0].push_back(Value());
+        mixed[1].push_back(Value((LongInt)7));
+        mixed[1].push_back(Value(7));
+        mixed[1].push_back(Value());
+        cursor->exec_many(mixed);
+        conn.commit();
+
+        conn.prepare(_T("SELECT ID, A, C FROM T_ODBC_TEST ORDER BY ID"));
+        conn.exec(Values());
+        RowsPtr rows = conn.fetch_rows();
+        CPPUNIT_ASSERT_EQUAL(7, (int)rows->size());
+        CPPUNIT_ASSERT((*rows)[2][1].is_null());
+        CPPUNIT_ASSERT_EQUAL(string("many"),
+                NARROW((*rows)[4][1].as_string()));
+        CPPUNIT_ASSERT(dt_make(2001, 1, 5) == (*rows)[4][2].as_date_time());
+        CPPUNIT_ASSERT_EQUAL(string("7"), NARROW((*rows)[6][1].as_string()));
+        CPPUNIT_ASSERT((*rows)[6][2].is_null());
+    }
+
+    void test_fetch_array()
+    {
+        if (str_empty(dsn_))
+            return;
+        {
+            SqlConnection conn(odbc_source(dsn_));
+            conn.begin_trans_if_necessary();
+            insert_rows(conn, 5);
+            conn.commit();
+        }
+        tiodbc::connection conn;
+        CPPUNIT_ASSERT(conn.connect(dsn_, _T(""), _T("")));
+        tiodbc::statement stmt;
+        CPPUNIT_ASSERT(stmt.execute_direct(conn,
+                    _T("SELECT ID, A, B FROM T_ODBC_TEST ORDER BY ID")));
+        tiodbc::row_array rows(2);
+        CPPUNIT_ASSERT(stmt.bind_array(rows));
+        CPPUNIT_ASSERT_EQUAL(3, rows.count_bound());
+        // the rows come in blocks of 2, the last block is short
+        const int expected[] = { 2, 2, 1, 0 };
+        for (int k = 0, id = 1; k < 4; ++k) {
+            CPPUNIT_ASSERT_EQUAL(expected[k], stmt.fetch_array(rows));
+            CPPUNIT_ASSERT_EQUAL(expected[k], rows.count_rows());
+            for (int r = 0; r < expected[k]; ++r, ++id) {
+                CPPUNIT_ASSERT_EQUAL(id, (int)rows.field(1, r).as_long());
+                CPPUNIT_ASSERT_EQUAL(id == 2,
+                        (bool)rows.field(2, r).is_null());
+                CPPUNIT_ASSERT_EQUAL(0.5 * (id - 1),
+                        rows.field(3, r).as_double());
+            }
+        }
+    }
+
+    void test_fetch_array_lob()
+    {
+        if (str_empty(dsn_))
+            return;
+        {
+            SqlConnection conn(odbc_source(dsn_));
+            conn.begin_trans_if_necessary();
+            insert_rows(conn, 3);
+            conn.commit();
+        }
+        tiodbc::connection conn;
+        CPPUNIT_ASSERT(conn.connect(dsn_, _T(""), _T("")));
+        tiodbc::statement stmt;
+        CPPUNIT_ASSERT(stmt.execute_direct(conn,
+                    _T("SELECT ID, D, A FROM T_ODBC_TEST ORDER BY ID")));
+        // D is wider than the LOB threshold, it and A are left unbound
+        tiodbc::row_array rows(4, 100);
+        CPPUNIT_ASSERT(stmt.bind_array(rows));
+        CPPUNIT_ASSERT_EQUAL(1, rows.count_bound());
+        CPPUNIT_ASSERT(rows.is_bound(1) && !rows.is_bound(2));
+        for (int id = 1; id <= 3; ++id) {
+            // one row at a time, the rest is read with SQLGetData
+            CPPUNIT_ASSERT_EQUAL(1, stmt.fetch_array(rows));
+            CPPUNIT_ASSERT_EQUAL(id, (int)rows.field(1, 0).as_long());
+            CPPUNIT_ASSERT_EQUAL(300, (int)stmt.field(2).as_string().size());
+            CPPUNIT_ASSERT_EQUAL(id == 2, (bool)stmt.field(3).is_null());
+        }
+        CPPUNIT_ASSERT_EQUAL(0, stmt.fetch_array(rows));
+    }
+
+    void test_row_block()
+    {
+        if (str_empty(dsn_))
+            return;
+        SqlSource src = odbc_source(dsn_);
+        src[_T("row_block")] = _T("2");
+        src[_T("lob_size")] = _T("100");
+        SqlConnection conn(src);
+        conn.begin_trans_if_necessary();
+        insert_rows(conn, 5);
+        auto_ptr<SqlCursor> cursor = conn.new_cursor();
+        cursor->prepare(_T("SELECT ID, A, B FROM T_ODBC_TEST ORDER BY ID"));
+        cursor->exec(Values());
+        RowBlock block;
+        CPPUNIT_ASSERT_EQUAL(3, (int)cursor->fetch_block(block, 3));
+        CPPUNIT_ASSERT_EQUAL((LongInt)3, block[2].get(_T("ID")).as_longint());
+        CPPUNIT_ASSERT(block[1].get(_T("A")).is_null());
+        CPPUNIT_ASSERT_EQUAL(2, (int)cursor->fetch_block(block, 3));
+        CPPUNIT_ASSERT_EQUAL(1.5, block[0].get(_T("B")).as_float());
+        CPPUNIT_ASSERT_EQUAL(0, (int)cursor->fetch_block(block, 3));
+        // a column over lob_size falls back to fetching row by row
+        cursor->prepare(_T("SELECT ID, D FROM T_ODBC_TEST ORDER BY ID"));
+        cursor->exec(Values());
+        RowsPtr rows = cursor->fetch_rows();
+        CPPUNIT_ASSERT_EQUAL(5, (int)rows->size());
+        CPPUNIT_ASSERT_EQUAL((LongInt)5, (*rows)[4][0].as_longint());
+        CPPUNIT_ASSERT_EQUAL(300, (int)(*rows)[4][1].as_string().size());
+        conn.commit();
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestOdbcDriver);
+
+#endif // YB_USE_ODBC
+
+// vim:ts=4:sts=4:sw=4:et:
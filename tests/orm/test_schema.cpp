@@ -16,6 +16,7 @@ class TestMetaData : public CppUnit::TestFixture
     CPPUNIT_TEST(test_table_seq);
     CPPUNIT_TEST(test_table_surrogate_pk);
     CPPUNIT_TEST(test_rel_join_cond);
+    CPPUNIT_TEST(test_rel_joined_order_by);
     CPPUNIT_TEST(test_get_fk_for);
     CPPUNIT_TEST_EXCEPTION(test_table_bad_surrogate_pk__no_pk, TableHasNoSurrogatePK);
     CPPUNIT_TEST_EXCEPTION(test_table_bad_surrogate_pk__complex, TableHasNoSurrogatePK);
@@ -31,6 +32,7 @@ class TestMetaData : public CppUnit::TestFixture
     CPPUNIT_TEST_EXCEPTION(test_registry_check_absent_fk_table, IntegrityCheckFailed);
     CPPUNIT_TEST_EXCEPTION(test_registry_check_absent_fk_field, IntegrityCheckFailed);
     CPPUNIT_TEST_EXCEPTION(test_registry_check_cyclic_references, IntegrityCheckFailed);
+    CPPUNIT_TEST(test_flush_order);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -135,6 +137,29 @@ public:
                 NARROW(r.join_expr(tables).get_sql()));
     }
 
+    void test_rel_joined_order_by()
+    {
+        Schema r;
+        Table::Ptr ta(new Table(_T("A"), _T(""), _T("A")));
+        ta->add_column(Column(_T("X"), Value::LONGINT, 0, Column::PK | Column::RO));
+        r.add_table(ta);
+        Table::Ptr tc(new Table(_T("C"), _T(""), _T("C")));
+        tc->add_column(Column(_T("X"), Value::LONGINT, 0, Column::PK | Column::RO));
+        tc->add_column(Column(_T("AX"), Value::LONGINT, 0, 0,
+                    Value(), _T("A"), _T("")));
+        r.add_table(tc);
+        Relation::AttrMap a1, a2;
+        a1[_T("property")] = _T("cs");
+        a2[_T("property")] = _T("a");
+        a2[_T("order-by")] = _T("X DESC,A.X, LOWER(AX), 2");
+        Relation::Ptr re1(new Relation(Relation::ONE2MANY,
+            _T("A"), a1, _T("C"), a2));
+        r.add_relation(re1);
+        r.fill_fkeys();
+        CPPUNIT_ASSERT_EQUAL(string("C.X DESC, A.X, LOWER(AX), 2"),
+                NARROW(re1->joined_order_by()));
+    }
+
     void test_get_fk_for()
     {
         Schema r;
@@ -365,6 +390,48 @@ public:
         *t1 << Column(_T("BX"), Value::LONGINT, 0, 0, Value(), _T("B"), _T("X"));
         r.check_cycles();
     }
+
+    void test_flush_order()
+    {
+        Table::Ptr t1(new Table(_T("A")));
+        *t1 << Column(_T("X"), Value::LONGINT, 0, Column::PK)
+            << Column(_T("DX"), Value::LONGINT, 0, 0, Value(), _T("D"), _T("X"));
+        Table::Ptr t2(new Table(_T("B")));
+        *t2 << Column(_T("X"), Value::LONGINT, 0, Column::PK)
+            << Column(_T("CX"), Value::LONGINT, 0, 0, Value(), _T("C"), _T("X"));
+        Table::Ptr t3(new Table(_T("C")));
+        *t3 << Column(_T("X"), Value::LONGINT, 0, Column::PK)
+            << Column(_T("AX"), Value::LONGINT, 0, 0, Value(), _T("A"), _T("X"))
+            << Column(_T("PX"), Value::LONGINT, 0, 0, Value(), _T("C"), _T("X"));
+        Table::Ptr t4(new Table(_T("D")));
+        *t4 << Column(_T("X"), Value::LONGINT, 0, Column::PK);
+        Schema r;
+        r << t1 << t2 << t3 << t4;
+        // without fill_fkeys() the depths can still be calculated
+        CPPUNIT_ASSERT(!r.depths_filled());
+        map<String, int> depths;
+        r.calc_depths(depths, false);
+        CPPUNIT_ASSERT_EQUAL(1, depths[_T("D")]);
+        CPPUNIT_ASSERT_EQUAL(2, depths[_T("A")]);
+        CPPUNIT_ASSERT_EQUAL(3, depths[_T("C")]);
+        CPPUNIT_ASSERT_EQUAL(4, depths[_T("B")]);
+        r.fill_fkeys();
+        CPPUNIT_ASSERT(r.depths_filled());
+        CPPUNIT_ASSERT_EQUAL(1, t4->get_depth());
+        CPPUNIT_ASSERT_EQUAL(2, t1->get_depth());
+        CPPUNIT_ASSERT_EQUAL(3, t3->get_depth());
+        CPPUNIT_ASSERT_EQUAL(4, t2->get_depth());
+        CPPUNIT_ASSERT(t3->self_ref());
+        CPPUNIT_ASSERT(!t1->self_ref() && !t2->self_ref() && !t4->self_ref());
+        // check_cycles() gives the same depths
+        r.check_cycles();
+        CPPUNIT_ASSERT_EQUAL(3, t3->get_depth());
+        CPPUNIT_ASSERT_EQUAL(4, t2->get_depth());
+        Table::Ptr t5(new Table(_T("E")));
+        *t5 << Column(_T("X"), Value::LONGINT, 0, Column::PK);
+        r << t5;
+        CPPUNIT_ASSERT(!r.depths_filled());
+    }
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(TestMetaData);
@@ -0,0 +1,193 @@
+#if defined(YB_USE_SOCI)
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/TestAssert.h>
+#include "util/string_utils.h"
+#include "orm/sql_driver.h"
+#include "orm/engine.h"
+
+using namespace std;
+using namespace Yb;
+
+// The tests use the SOCI connection URL given in YBORM_SOCI_URL,
+// like sqlite+soci://dbname=/tmp/test1_db_soci.sqlite, and do nothing
+// if it is not set.
+
+class TestSociDriver : public CppUnit::TestFixture
+{
+    CPPUNIT_TEST_SUITE(TestSociDriver);
+    CPPUNIT_TEST(test_exec_many);
+    CPPUNIT_TEST(test_bulk_select);
+    CPPUNIT_TEST(test_bulk_select_wo_params);
+    CPPUNIT_TEST(test_stmt_cache);
+    CPPUNIT_TEST_SUITE_END();
+
+    String url_;
+
+    SqlSource source() const
+    {
+        SqlSource src(url_);
+        src[_T("fetch_block")] = _T("3");
+        return src;
+    }
+
+    void insert_rows(SqlConnection &conn, int count)
+    {
+        std::vector<Values> params_list(count);
+        for (int i = 0; i < count; ++i) {
+            params_list[i].push_back(Value((LongInt)i + 1));
+            params_list[i].push_back(i == 1? Value(): Value(_T("bulk")));
+        }
+        auto_ptr<SqlCursor> cursor = conn.new_cursor();
+        cursor->prepare(_T("INSERT INTO T_SOCI_TEST(ID, A) VALUES(?, ?)"));
+        cursor->exec_many(params_list);
+    }
+public:
+    void setUp()
+    {
+        url_ = env_cfg(_T("SOCI_URL"));
+        if (str_empty(url_))
+            return;
+        SqlConnection conn(source());
+        conn.begin_trans_if_necessary();
+        conn.exec_direct(_T("DROP TABLE IF EXISTS T_SOCI_TEST"));
+        conn.exec_direct(_T("CREATE TABLE T_SOCI_TEST(ID INTEGER PRIMARY KEY, ")
+                _T("A VARCHAR(20))"));
+        conn.commit();
+    }
+
+    void test_exec_many()
+    {
+        if (str_empty(url_))
+            return;
+        SqlConnection conn(source());
+        conn.set_convert_params(true);
+        conn.begin_trans_if_necessary();
+        auto_ptr<SqlCursor> cursor = conn.new_cursor();
+        cursor->prepare(_T("INSERT INTO T_SOCI_TEST(ID, A) VALUES(?, ?)"));
+        std::vector<Values> params_list(3);
+        for (size_t i = 0; i < params_list.size(); ++i) {
+            params_list[i].push_back(Value((LongInt)i + 1));
+            params_list[i].push_back(Value(_T("first")));
+        }
+        cursor->exec_many(params_list);
+        // the same statement is used again, with fewer rows
+        params_list.resize(2);
+        for (size_t i = 0; i < params_list.size(); ++i) {
+            params_list[i][0] = Value((LongInt)i + 4);
+            params_list[i][1] = i? Value(): Value(_T("second"));
+        }
+        cursor->exec_many(params_list);
+        // another type of a parameter makes a new statement
+        params_list[0][0] = Value(_T("6"));
+        params_list[1][0] = Value(_T("7"));
+        cursor->exec_many(params_list);
+        conn.commit();
+
+        conn.prepare(_T("SELECT ID, A FROM T_SOCI_TEST ORDER BY ID"));
+        conn.exec(Values());
+        RowsPtr rows = conn.fetch_rows();
+        CPPUNIT_ASSERT_EQUAL(7, (int)rows->size());
+        CPPUNIT_ASSERT_EQUAL(string("first"),
+                NARROW((*rows)[2].get(_T("A")).as_string()));
+        CPPUNIT_ASSERT_EQUAL(string("second"),
+                NARROW((*rows)[3].get(_T("A")).as_string()));
+        CPPUNIT_ASSERT((*rows)[4].get(_T("A")).is_null());
+        CPPUNIT_ASSERT_EQUAL((LongInt)7,
+                (*rows)[6].get(_T("ID")).as_longint());
+    }
+
+    void test_bulk_select()
+    {
+        if (str_empty(url_))
+            return;
+        SqlConnection conn(source());
+        conn.set_convert_params(true);
+        conn.begin_trans_if_necessary();
+        insert_rows(conn, 7);
+        auto_ptr<SqlCursor> cursor = conn.new_cursor();
+        cursor->prepare(
+                _T("SELECT ID, A FROM T_SOCI_TEST WHERE ID > ? ORDER BY ID"));
+        cursor->bind_params(TypeCodes(1, Value::LONGINT));
+        Values params(1, Value((LongInt)0));
+        cursor->exec(params);
+        // the very first execution is fetched in blocks of 3
+        RowBlock block;
+        CPPUNIT_ASSERT_EQUAL(5, (int)cursor->fetch_block(block, 5));
+        CPPUNIT_ASSERT_EQUAL((LongInt)1, block[0].get(_T("ID")).as_longint());
+        CPPUNIT_ASSERT(block[1].get(_T("A")).is_null());
+        CPPUNIT_ASSERT_EQUAL(string("bulk"),
+                NARROW(block[4].get(_T("A")).as_string()));
+        CPPUNIT_ASSERT_EQUAL(2, (int)cursor->fetch_block(block, 5));
+        CPPUNIT_ASSERT_EQUAL((LongInt)7, block[1].get(_T("ID")).as_longint());
+        CPPUNIT_ASSERT_EQUAL(0, (int)cursor->fetch_block(block, 5));
+        params[0] = Value((LongInt)4);
+        cursor->exec(params);
+        RowPtr row = cursor->fetch_row();
+        CPPUNIT_ASSERT(row.get() != NULL);
+        CPPUNIT_ASSERT_EQUAL((LongInt)5, row->get(_T("ID")).as_longint());
+        CPPUNIT_ASSERT_EQUAL(2, (int)cursor->fetch_block(block, 5));
+        CPPUNIT_ASSERT(cursor->fetch_row().get() == NULL);
+    }
+
+    void test_bulk_select_wo_params()
+    {
+        if (str_empty(url_))
+            return;
+        SqlConnection conn(source());
+        conn.set_convert_params(true);
+        conn.begin_trans_if_necessary();
+        auto_ptr<SqlCursor> cursor = conn.new_cursor();
+        cursor->prepare(_T("SELECT COUNT(*) CNT FROM T_SOCI_TEST"));
+        cursor->exec(Values());
+        RowPtr row = cursor->fetch_row();
+        CPPUNIT_ASSERT(row.get() != NULL);
+        CPPUNIT_ASSERT_EQUAL(0, (int)row->get(_T("CNT")).as_longint());
+        insert_rows(conn, 4);
+        cursor->exec(Values());
+        row = cursor->fetch_row();
+        CPPUNIT_ASSERT(row.get() != NULL);
+        CPPUNIT_ASSERT_EQUAL(4, (int)row->get(_T("CNT")).as_longint());
+        CPPUNIT_ASSERT(cursor->fetch_row().get() == NULL);
+    }
+
+    void test_stmt_cache()
+    {
+        if (str_empty(url_))
+            return;
+        SqlConnection conn(source());
+        conn.set_convert_params(true);
+        conn.set_stmt_cache_size(1);
+        conn.begin_trans_if_necessary();
+        insert_rows(conn, 7);
+        const String sql =
+            _T("SELECT ID FROM T_SOCI_TEST WHERE ID > ? ORDER BY ID");
+        Values params(1, Value((LongInt)0));
+        {
+            auto_ptr<SqlCursor> cursor = conn.new_cursor();
+            cursor->prepare(sql);
+            cursor->bind_params(TypeCodes(1, Value::LONGINT));
+            cursor->exec(params);
+            // a block of rows is fetched ahead, but only one is read
+            RowPtr row = cursor->fetch_row();
+            CPPUNIT_ASSERT_EQUAL((LongInt)1, row->get(_T("ID")).as_longint());
+        }
+        CPPUNIT_ASSERT_EQUAL(1, (int)conn.stmt_cache_count());
+        auto_ptr<SqlCursor> cursor = conn.new_cursor();
+        cursor->prepare(sql);
+        CPPUNIT_ASSERT_EQUAL(0, (int)conn.stmt_cache_count());
+        cursor->bind_params(TypeCodes(1, Value::LONGINT));
+        // the rows left from the first use are gone
+        RowBlock block;
+        CPPUNIT_ASSERT_EQUAL(0, (int)cursor->fetch_block(block, 5));
+        params[0] = Value((LongInt)5);
+        cursor->exec(params);
+        CPPUNIT_ASSERT_EQUAL(2, (int)cursor->fetch_block(block, 5));
+        CPPUNIT_ASSERT_EQUAL((LongInt)6, block[0].get(_T("ID")).as_longint());
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestSociDriver);
+
+#endif // YB_USE_SOCI
+
+// vim:ts=4:sts=4:sw=4:et:
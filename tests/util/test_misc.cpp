@@ -5,6 +5,7 @@
 
 #include "util/string_utils.h"
 #include "util/element_tree.h"
+#include "util/object_pool.h"
 
 using namespace std;
 using namespace Yb;
@@ -28,6 +29,7 @@ class TestMisc: public CppUnit::TestFixture
     CPPUNIT_TEST(testUrlDecode);
     CPPUNIT_TEST(testParseUrl);
     CPPUNIT_TEST(testFormatUrl);
+    CPPUNIT_TEST(testObjectPool);
 
     CPPUNIT_TEST_SUITE_END();   
 
@@ -193,8 +195,44 @@ public:
                 NARROW(format_url(d, false)));
     }
 
+
+    struct Pooled: public RefCountBase, public PoolObject
+    {
+        int x[10];
+        static int alive;
+        Pooled() { ++alive; }
+        ~Pooled() { --alive; }
+    };
+
+    void testObjectPool()
+    {
+        typedef IntrusivePtr<Pooled> PooledPtr;
+        ObjectPool::Ptr pool(new ObjectPool(1024));
+        vector<PooledPtr> objs;
+        for (int i = 0; i < 100; ++i)
+            objs.push_back(PooledPtr(new (pool.get()) Pooled()));
+        PooledPtr heap_obj(new Pooled());
+        CPPUNIT_ASSERT_EQUAL(101, Pooled::alive);
+        CPPUNIT_ASSERT_EQUAL((size_t)100, pool->used());
+        size_t chunks = pool->chunks();
+        CPPUNIT_ASSERT(chunks > 1);
+        // freed blocks are reused
+        objs.resize(50);
+        CPPUNIT_ASSERT_EQUAL((size_t)50, pool->used());
+        for (int i = 0; i < 50; ++i)
+            objs.push_back(PooledPtr(new (pool.get()) Pooled()));
+        CPPUNIT_ASSERT_EQUAL(chunks, pool->chunks());
+        // the objects keep the pool alive
+        ObjectPool *p = pool.get();
+        pool = ObjectPool::Ptr();
+        CPPUNIT_ASSERT_EQUAL((size_t)100, p->used());
+        objs.clear();
+        CPPUNIT_ASSERT_EQUAL(1, Pooled::alive);
+    }
 };
 
+int TestMisc::Pooled::alive = 0;
+
 CPPUNIT_TEST_SUITE_REGISTRATION(TestMisc);
 
 class TestDict: public CppUnit::TestFixture
@@ -9,17 +9,22 @@ typedef vector<Item> Items;
 
 class MockResultSet: public Yb::ResultSetBase<Item> {
     Items::reverse_iterator start_, finish_;
+    int fetched_;
     bool fetch(Item &item) {
         if (start_ == finish_)
             return false;
         item = *start_;
         ++start_;
+        ++fetched_;
         return true;
     }
 public:
-    MockResultSet(Items &items)
-        : start_(items.rbegin()), finish_(items.rend())
+    MockResultSet(Items &items, size_t prefetch = 1)
+        : Yb::ResultSetBase<Item>(prefetch)
+        , start_(items.rbegin()), finish_(items.rend())
+        , fetched_(0)
     {}
+    int fetched() const { return fetched_; }
 };
 
 class TestResultSet: public CppUnit::TestFixture
@@ -30,6 +35,9 @@ class TestResultSet: public CppUnit::TestFixture
     CPPUNIT_TEST(testCopy);
     CPPUNIT_TEST(testLimitedCopy2);
     CPPUNIT_TEST(testLimitedCopy0);
+    CPPUNIT_TEST(testPrefetch);
+    CPPUNIT_TEST(testLoad);
+    CPPUNIT_TEST(testMove);
     CPPUNIT_TEST_EXCEPTION(testThrows, Yb::AssertError);
 
     CPPUNIT_TEST_SUITE_END();
@@ -89,6 +97,58 @@ public:
         CPPUNIT_ASSERT_EQUAL((size_t)0, out.size());
     }
 
+    void testPrefetch()
+    {
+        Items items(5);
+        for (int i = 0; i < 5; ++i)
+            items[i] = 10 + i;
+        MockResultSet rs(items, 2);
+        MockResultSet::iterator it = rs.begin(), end = rs.end();
+        CPPUNIT_ASSERT_EQUAL(14, *it);
+        CPPUNIT_ASSERT_EQUAL(2, rs.fetched());
+        int *prev = it++;
+        CPPUNIT_ASSERT_EQUAL(13, *it);
+        CPPUNIT_ASSERT_EQUAL(14, *prev);
+        CPPUNIT_ASSERT_EQUAL(2, rs.fetched());
+        prev = it++;
+        CPPUNIT_ASSERT_EQUAL(12, *it);
+        CPPUNIT_ASSERT_EQUAL(13, *prev);
+        CPPUNIT_ASSERT_EQUAL(4, rs.fetched());
+        ++it; ++it;
+        CPPUNIT_ASSERT_EQUAL(10, *it);
+        CPPUNIT_ASSERT_EQUAL(5, rs.fetched());
+        ++it;
+        CPPUNIT_ASSERT(it == end);
+    }
+
+    void testLoad()
+    {
+        Items items(7), out;
+        for (int i = 0; i < 7; ++i)
+            items[i] = 10 + i;
+        MockResultSet rs(items);
+        CPPUNIT_ASSERT_EQUAL(16, *rs.begin());
+        rs.load();
+        CPPUNIT_ASSERT_EQUAL(7, rs.fetched());
+        Yb::copy_no_more_than_n(rs.begin(), rs.end(), -1,
+                std::back_inserter(out));
+        CPPUNIT_ASSERT_EQUAL((size_t)7, out.size());
+        for (int i = 0; i < 7; ++i)
+            CPPUNIT_ASSERT_EQUAL(16 - i, out[i]);
+    }
+
+    void testMove()
+    {
+        Items items(3);
+        items[0] = 10; items[1] = 11; items[2] = 12;
+        MockResultSet rs(items);
+        Items out;
+        Yb::move_no_more_than_n(rs.begin(), rs.end(), 2, out);
+        CPPUNIT_ASSERT_EQUAL((size_t)2, out.size());
+        CPPUNIT_ASSERT_EQUAL(12, out[0]);
+        CPPUNIT_ASSERT_EQUAL(11, out[1]);
+    }
+
     void testThrows()
     {
         Items items;